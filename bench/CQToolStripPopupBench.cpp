@@ -0,0 +1,321 @@
+#include <CQToolStripPopupBench.h>
+#include <CQToolStrip.h>
+#include <CQToolStripRecorder.h>
+#include <QApplication>
+#include <QVBoxLayout>
+#include <QPushButton>
+#include <QLineEdit>
+#include <QComboBox>
+#include <QCheckBox>
+#include <QToolButton>
+#include <QLabel>
+#include <QFile>
+#include <QJsonArray>
+#include <QJsonDocument>
+#include <QElapsedTimer>
+#include <iostream>
+#include <algorithm>
+#include <cstring>
+
+namespace {
+
+// min/max/mean of repeated measurement (ms)
+struct Stat {
+  double sum, min, max;
+  int    n;
+
+  Stat() :
+   sum(0.0), min(0.0), max(0.0), n(0) {
+  }
+
+  void add(double t) {
+    min = (n > 0 ? std::min(min, t) : t);
+    max = (n > 0 ? std::max(max, t) : t);
+
+    sum += t;
+
+    ++n;
+  }
+
+  QJsonObject toJson() const {
+    QJsonObject obj;
+
+    obj["mean"] = (n > 0 ? sum/n : 0.0);
+    obj["min" ] = min;
+    obj["max" ] = max;
+
+    return obj;
+  }
+};
+
+// max time (ms) to wait for menu paint
+const int paintTimeout = 1000;
+
+}
+
+int
+main(int argc, char **argv)
+{
+  CQToolStripPopupBench::Options options;
+
+  bool    show = false;
+  QString output;
+
+  for (int i = 1; i < argc; ++i) {
+    bool hasValue = (i < argc - 1);
+
+    if      (strcmp(argv[i], "-areas") == 0 && hasValue) {
+      options.counts.clear();
+
+      for (const auto &str : QString(argv[++i]).split(","))
+        options.counts.push_back(str.toInt());
+    }
+    else if (strcmp(argv[i], "-iterations") == 0 && hasValue)
+      options.iterations = std::max(QString(argv[++i]).toInt(), 1);
+    else if (strcmp(argv[i], "-adjust") == 0 && hasValue)
+      options.adjustEvents = std::max(QString(argv[++i]).toInt(), 0);
+    else if (strcmp(argv[i], "-host") == 0)
+      options.popupHost = true;
+    else if (strcmp(argv[i], "-show") == 0)
+      show = true;
+    else if (strcmp(argv[i], "-o") == 0 && hasValue)
+      output = argv[++i];
+    else {
+      std::cerr << "Usage: CQToolStripPopupBench [-areas <n>,<n>,...] [-iterations <n>] "
+                   "[-adjust <n>] [-host] [-show] [-o <file>]" << std::endl;
+      return 1;
+    }
+  }
+
+  if (options.counts.empty())
+    options.counts = std::vector<int>({ 10, 30, 100, 300, 1000 });
+
+  // run offscreen unless shown (same result on any machine)
+  if (! show && qgetenv("QT_QPA_PLATFORM").isEmpty())
+    qputenv("QT_QPA_PLATFORM", "offscreen");
+
+  QApplication app(argc, argv);
+
+  CQToolStripPopupBench bench(options);
+
+  QJsonDocument doc(bench.exec());
+
+  if (output != "") {
+    QFile file(output);
+
+    if (! file.open(QIODevice::WriteOnly)) {
+      std::cerr << "Failed to write '" << output.toStdString() << "'" << std::endl;
+      return 1;
+    }
+
+    file.write(doc.toJson());
+  }
+  else
+    std::cout << doc.toJson().constData();
+
+  return 0;
+}
+
+CQToolStripPopupBench::
+CQToolStripPopupBench(const Options &options) :
+ options_(options), window_(0), strip_(0)
+{
+}
+
+QJsonObject
+CQToolStripPopupBench::
+exec()
+{
+  QJsonArray results;
+
+  for (int n : options_.counts)
+    results.append(run(n));
+
+  QJsonObject obj;
+
+  obj["benchmark"    ] = "popup";
+  obj["qt_version"   ] = qVersion();
+  obj["platform"     ] = QGuiApplication::platformName();
+  obj["popup_host"   ] = options_.popupHost;
+  obj["iterations"   ] = options_.iterations;
+  obj["adjust_events"] = options_.adjustEvents;
+  obj["results"      ] = results;
+
+  return obj;
+}
+
+QJsonObject
+CQToolStripPopupBench::
+run(int numAreas)
+{
+  typedef CQToolStripRecording Recording;
+
+  createStrip(numAreas);
+
+  auto *menu = strip_->menu();
+
+  menu->setPhaseTiming(true);
+
+  int numClipped = 0;
+
+  for (int i = 0; i < strip_->numAreas(); ++i) {
+    if (strip_->getArea(i)->isClipped())
+      ++numClipped;
+  }
+
+  Stat openTotal, aboutToShow, addActions, size, polish, paint;
+  Stat closeTotal, removeActions, relayout;
+  Stat adjust;
+
+  for (int i = 0; i < options_.iterations; ++i) {
+    // open (menu button click to first paint)
+    QElapsedTimer timer;
+
+    timer.start();
+
+    CQToolStripRecorder::applyEvent(strip_, Recording::Event(Recording::MenuOpenEvent));
+
+    // polish time is set on first paint (paint is done when event processing returns)
+    while (menu->phaseTimes().polish <= 0.0 && timer.elapsed() < paintTimeout)
+      QCoreApplication::processEvents(QEventLoop::AllEvents, 1);
+
+    double t = timer.nsecsElapsed()/1e6;
+
+    const auto &times = menu->phaseTimes();
+
+    openTotal  .add(t);
+    aboutToShow.add(times.aboutToShow);
+    addActions .add(times.open);
+    size       .add(times.size);
+    polish     .add(times.polish);
+    paint      .add(std::max(t - times.aboutToShow - times.polish, 0.0));
+
+    //---
+
+    // menu border drags (alternately grow and shrink)
+    for (int j = 0; j < options_.adjustEvents; ++j) {
+      int d = ((j/5) % 2 == 0 ? 4 : -4);
+
+      timer.restart();
+
+      CQToolStripRecorder::applyEvent(strip_,
+        Recording::Event(Recording::MenuRectEvent, 0, 0, 0, d, d));
+
+      processEvents();
+
+      adjust.add(timer.nsecsElapsed()/1e6);
+    }
+
+    //---
+
+    // close (remove menu contents and strip relayout)
+    timer.restart();
+
+    CQToolStripRecorder::applyEvent(strip_, Recording::Event(Recording::MenuCloseEvent));
+
+    processEvents();
+
+    closeTotal   .add(timer.nsecsElapsed()/1e6);
+    removeActions.add(std::max(times.close - menu->relayoutTime(), 0.0));
+    relayout     .add(menu->relayoutTime());
+  }
+
+  deleteStrip();
+
+  //---
+
+  QJsonObject open;
+
+  open["total_ms"        ] = openTotal  .toJson();
+  open["about_to_show_ms"] = aboutToShow.toJson();
+  open["add_actions_ms"  ] = addActions .toJson();
+  open["size_ms"         ] = size       .toJson();
+  open["polish_ms"       ] = polish     .toJson();
+  open["paint_ms"        ] = paint      .toJson();
+
+  QJsonObject close;
+
+  close["total_ms"         ] = closeTotal   .toJson();
+  close["remove_actions_ms"] = removeActions.toJson();
+  close["relayout_ms"      ] = relayout     .toJson();
+
+  QJsonObject obj;
+
+  obj["areas"     ] = numAreas;
+  obj["overflowed"] = numClipped;
+  obj["open"      ] = open;
+  obj["close"     ] = close;
+  obj["adjust_ms" ] = adjust.toJson();
+
+  return obj;
+}
+
+// narrow strip of mixed widget types (most areas overflowed)
+void
+CQToolStripPopupBench::
+createStrip(int numAreas)
+{
+  window_ = new QWidget;
+
+  QVBoxLayout *layout = new QVBoxLayout(window_);
+  layout->setContentsMargins(0, 0, 0, 0); layout->setSpacing(0);
+
+  strip_ = new CQToolStrip;
+
+  strip_->setPopupHost(options_.popupHost);
+
+  for (int i = 0; i < numAreas; ++i) {
+    QWidget *w = 0;
+
+    switch (i % 6) {
+      case 0: w = new QPushButton(QString("Button %1").arg(i)); break;
+      case 1: w = new QLineEdit; break;
+      case 2: {
+        QComboBox *combo = new QComboBox;
+
+        combo->addItems(QStringList() << "One" << "Two" << "Three");
+
+        w = combo;
+
+        break;
+      }
+      case 3: w = new QCheckBox(QString("Check %1").arg(i)); break;
+      case 4: w = new QToolButton; break;
+      case 5: w = new QLabel(QString("Label %1").arg(i)); break;
+    }
+
+    if (i % 2 == 0)
+      strip_->addWidget(QString("Area %1").arg(i), w);
+    else
+      strip_->addWidget(w);
+  }
+
+  layout->addWidget(strip_);
+  layout->addStretch();
+
+  window_->resize(400, 100);
+
+  window_->show();
+
+  processEvents();
+}
+
+void
+CQToolStripPopupBench::
+deleteStrip()
+{
+  delete window_;
+
+  window_ = 0;
+  strip_  = 0;
+
+  processEvents();
+}
+
+void
+CQToolStripPopupBench::
+processEvents()
+{
+  QCoreApplication::sendPostedEvents();
+  QCoreApplication::processEvents();
+}
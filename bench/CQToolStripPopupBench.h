@@ -0,0 +1,45 @@
+#include <QJsonObject>
+#include <QString>
+#include <vector>
+
+class CQToolStrip;
+class QWidget;
+
+/*!
+ * Benchmark overflow menu popup path for strips with increasing numbers of
+ * overflowed areas: open (click to first paint, split by phase), close (remove
+ * menu contents and strip relayout) and menu border drags.
+ */
+class CQToolStripPopupBench {
+ public:
+  struct Options {
+    std::vector<int> counts;       // numbers of areas
+    int              iterations;   // open/close per count
+    int              adjustEvents; // menu border drag events per iteration
+    bool             popupHost;    // use lightweight popup window
+
+    Options() :
+     iterations(10), adjustEvents(20), popupHost(false) {
+    }
+  };
+
+ public:
+  CQToolStripPopupBench(const Options &options);
+
+  //! run all counts and return results
+  QJsonObject exec();
+
+ private:
+  QJsonObject run(int numAreas);
+
+  void createStrip(int numAreas);
+
+  void deleteStrip();
+
+  void processEvents();
+
+ private:
+  Options      options_;
+  QWidget     *window_;
+  CQToolStrip *strip_;
+};
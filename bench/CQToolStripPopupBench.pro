@@ -0,0 +1,28 @@
+TEMPLATE = app
+
+TARGET = CQToolStripPopupBench
+
+DEPENDPATH += .
+
+QT += widgets concurrent
+
+#CONFIG += debug
+
+# Input
+SOURCES += \
+CQToolStripPopupBench.cpp \
+
+HEADERS += \
+CQToolStripPopupBench.h \
+
+DESTDIR     = .
+OBJECTS_DIR = .
+
+INCLUDEPATH += \
+../include \
+../../CQToolStrip/include \
+.
+
+unix:LIBS += \
+-L../lib \
+-lCQToolStrip
@@ -4,17 +4,20 @@
 #include <QMenu>
 #include <QFrame>
 #include <QWidgetAction>
+#include <QElapsedTimer>
 
 class QScrollBar;
 class QVBoxLayout;
 class CQFrameMenuFrame;
 class CQFrameMenuAction;
 class CQFrameMenuScrollArea;
+class CQFrameMenuPopup;
 
 class CQFrameMenu : public QMenu {
   Q_OBJECT
 
   Q_PROPERTY(bool scrollable READ scrollable WRITE setScrollable)
+  Q_PROPERTY(bool popupHost  READ isPopupHost WRITE setPopupHost)
 
  public:
   enum Side {
@@ -34,8 +37,22 @@ class CQFrameMenu : public QMenu {
     ALL_SIDES = (LEFT_SIDE|RIGHT_SIDE|TOP_SIDE|BOTTOM_SIDE)
   };
 
+  //! times (ms) of last show/hide phases (when phase timing enabled)
+  struct PhaseTimes {
+    double aboutToShow; //!< show setup (includes open and size)
+    double open;        //!< openMenu handlers (add contents)
+    double size;        //!< initial size (initSize/applySize)
+    double polish;      //!< end of show setup to first paint (polish, layout and show)
+    double close;       //!< closeMenu handlers (remove contents)
+
+    PhaseTimes() :
+     aboutToShow(0.0), open(0.0), size(0.0), polish(0.0), close(0.0) {
+    }
+  };
+
  public:
   CQFrameMenu(bool scrollable=false);
+ ~CQFrameMenu();
 
   QFrame *frame() const;
 
@@ -43,6 +60,14 @@ class CQFrameMenu : public QMenu {
   bool scrollable() const { return scrollable_; }
   void setScrollable(bool scrollable);
 
+  //! get/set show frame in lightweight Qt::Popup window (frame stays parented to
+  //! window) instead of as QMenu action widget. Must be shown using popup().
+  bool isPopupHost() const { return popupHost_; }
+  void setPopupHost(bool b);
+
+  //! is menu (or popup host window) shown
+  bool isOpen() const;
+
   //! get/set resize sides
   uint resizeSides() const { return resizeSides_; }
   void setResizeSides(uint sides);
@@ -61,10 +86,27 @@ class CQFrameMenu : public QMenu {
   //! popup at global position
   void popup(const QPoint &gpos);
 
+  //! hide menu (or popup host window)
+  void hidePopup();
+
   void adjustMenuRect(int dxl, int dyb, int dxr, int dyt);
 
   void initSize(const QSize &s);
 
+  //! update open menu for changed widget contents
+  void updateContents();
+
+  //! create and polish frame and set known contents size before show
+  //! (so show doesn't need to calculate it). Scroll areas are shared by all menus
+  //! so a scrollable menu only makes sure one is created and polished in the pool
+  void prewarm(const QSize &contentsSize);
+
+  //! get/set record times of show/hide phases (for benchmarks)
+  bool isPhaseTiming() const { return phaseTiming_; }
+  void setPhaseTiming(bool b) { phaseTiming_ = b; }
+
+  const PhaseTimes &phaseTimes() const { return phaseTimes_; }
+
   void processFrameEvent(QFrame *frame, QEvent *e);
 
   bool insideBorder(QFrame *frame, const QPoint &p, Side &side) const;
@@ -75,6 +117,17 @@ class CQFrameMenu : public QMenu {
   void openMenu();
   void closeMenu();
 
+  //! emitted when menu rect is changed by border drag
+  void menuRectAdjusted(int dxl, int dyb, int dxr, int dyt);
+
+ protected:
+  friend class CQFrameMenuPopup;
+
+  //! called on paint of menu (or popup host window)
+  virtual void popupPaintEvent() { }
+
+  void paintEvent(QPaintEvent *e) override;
+
  private slots:
   void aboutToShowSlot();
   void aboutToHideSlot();
@@ -82,18 +135,37 @@ class CQFrameMenu : public QMenu {
  private:
   void initFrame();
 
+  void releaseFrame();
+
+  // record time to first paint after show
+  void phasePaint();
+
+  // window containing frame (menu or popup host window)
+  QWidget *popupWindow() const;
+
+  // frame offset in window
+  QPoint frameOffset() const;
+
  private:
   bool                   scrollable_;
+  bool                   popupHost_;
+  CQFrameMenuPopup      *popup_;
   uint                   resizeSides_;
   QWidget               *popupWidget_;
+  QWidget               *widget_;
   bool                   sizeHintIsMax_;
   CQFrameMenuFrame      *frame_;
   CQFrameMenuAction     *action_;
   CQFrameMenuScrollArea *scrollArea_;
+  QSize                  savedSize_;
+  QSize                  contentsSize_;
   bool                   sideInited_;
   bool                   pressed_;
   QPoint                 pressPos_;
   CQFrameMenu::Side      pressSide_;
+  bool                   phaseTiming_;
+  PhaseTimes             phaseTimes_;
+  QElapsedTimer          phaseTimer_;
 };
 
 class CQFrameMenuFrame : public QFrame {
@@ -115,6 +187,25 @@ class CQFrameMenuFrame : public QFrame {
   QVBoxLayout *layout_;
 };
 
+//! lightweight popup window for CQFrameMenu frame
+class CQFrameMenuPopup : public QWidget {
+  Q_OBJECT
+
+ public:
+  CQFrameMenuPopup(CQFrameMenu *menu);
+
+  void setFrame(QFrame *frame);
+
+ private:
+  void hideEvent(QHideEvent *) override;
+
+  void paintEvent(QPaintEvent *) override;
+
+ private:
+  CQFrameMenu *menu_;
+  QFrame      *frame_;
+};
+
 class CQFrameMenuAction : public QWidgetAction {
  public:
   CQFrameMenuAction(CQFrameMenu *menu);
@@ -132,10 +223,32 @@ class CQFrameMenuScrollArea : public QFrame {
  public:
   CQFrameMenuScrollArea(CQFrameMenu *menu);
 
+  //! get scroll area for menu from shared pool (created if pool empty)
+  static CQFrameMenuScrollArea *acquire(CQFrameMenu *menu);
+
+  //! make sure shared pool has a (created and polished) scroll area
+  static void reserve();
+
+  //! return scroll area to shared pool
+  static void release(CQFrameMenuScrollArea *area);
+
+  //! number of scroll areas created (in use or in pool) and number in pool
+  static int numCreated();
+  static int poolSize();
+
+  //! get/set size (kept by menu when scroll area is in pool)
+  QSize savedSize() const { return QSize(cw_, ch_); }
+  void setSavedSize(const QSize &s);
+
   void setWidget(QWidget *w);
 
   QWidget *widget() const { return w_; }
 
+  //! get/set cached widget minimum size (calculated if not set)
+  QSize contentsSize() const;
+  void setContentsSize(const QSize &s);
+  void invalidateContentsSize();
+
   QSize initSize();
 
   void applySize(int w, int h);
@@ -164,6 +277,7 @@ class CQFrameMenuScrollArea : public QFrame {
   QScrollBar  *hbar_;
   QScrollBar  *vbar_;
   int          cw_, ch_;
+  QSize        contentsSize_;
 };
 
 #endif
@@ -1,3 +1,6 @@
+#ifndef CQToolStrip_H
+#define CQToolStrip_H
+
 /*!
  * Horizontal/Vertical bar of widgets where each widget can be resizable or fixed width.
  *
@@ -6,27 +9,111 @@
  */
 
 #include <QToolButton>
+#include <QElapsedTimer>
 #include <CQFrameMenu.h>
+#include <CQToolStripSegmentTree.h>
+#include <CQToolStripGeometryTable.h>
+#include <CQToolStripSearchIndex.h>
+#include <map>
+#include <iosfwd>
 
 class CQToolStripArea;
+class CQToolStripGroup;
+class CQToolStripGroupButton;
+class CQToolStripColumnModel;
 class CQToolStripSplitter;
 class CQToolStripMenuButton;
+class CQToolStripWidgetFactory;
 class CQToolStripMenu;
 class QLabel;
+class QLineEdit;
+
+struct CQToolStripLayoutInput;
+struct CQToolStripLayoutResult;
+
+template<typename T> class QFutureWatcher;
+
+class QTimer;
 
 class CQToolStrip : public QWidget {
   Q_OBJECT
 
+ public:
+  enum OverflowPolicy {
+    OverflowMenu,   //!< areas which don't fit are moved to menu
+    OverflowScroll, //!< areas are scrolled (scroll buttons, wheel or drag)
+    OverflowWrap    //!< areas which don't fit are wrapped onto extra rows
+  };
+
+  //! estimated memory used by strip. Widget memory is reported as counts as Qt
+  //! private data is not visible (area widgets added by the application are not counted)
+  struct MemoryStats {
+    int numAreas;       //!< areas
+    int numLabels;      //!< area labels
+    int numSplitters;   //!< splitters
+    int numControls;    //!< menu button, scroll buttons and group buttons
+    int numMenus;       //!< overflow and group menus
+    int numMenuWidgets; //!< menu contents and search fields
+
+    size_t objectBytes; //!< strip objects (area, splitter and group data and labels)
+    size_t layoutBytes; //!< layout state (indices, lengths, rows and pending results)
+    size_t cacheBytes;  //!< caches (height for width, menu areas and search indices)
+
+    MemoryStats() :
+     numAreas(0), numLabels(0), numSplitters(0), numControls(0), numMenus(0),
+     numMenuWidgets(0), objectBytes(0), layoutBytes(0), cacheBytes(0) {
+    }
+
+    int numWidgets() const {
+      return numAreas + numLabels + numSplitters + numControls + numMenus + numMenuWidgets;
+    }
+
+    size_t totalBytes() const { return objectBytes + layoutBytes + cacheBytes; }
+  };
+
  public:
   CQToolStrip(QWidget *parent=0);
 
+  //! get/set orientation (direction areas are placed in)
   Qt::Orientation orientation() const { return orientation_; }
+  void setOrientation(Qt::Orientation orientation);
 
   CQToolStripArea *addWidget(QWidget *w);
   CQToolStripArea *addWidget(const QString &label, QWidget *w);
 
   void addArea(CQToolStripArea *area);
 
+  //! add areas at end (single layout for all areas)
+  void addAreas(const std::vector<CQToolStripArea *> &areas);
+
+  //! insert area at index (relayout from index)
+  void insertArea(int ind, CQToolStripArea *area);
+
+  //! remove area (area is not deleted and is no longer owned by strip)
+  CQToolStripArea *removeArea(int ind);
+  bool removeArea(CQToolStripArea *area);
+
+  //! move area to new index
+  void moveArea(int from, int to);
+
+  int areaIndex(CQToolStripArea *area) const;
+
+  //! add named group of consecutive areas (start to end inclusive). Returns 0 if name
+  //! is empty or already used, or range is empty or overlaps another group
+  CQToolStripGroup *addGroup(const QString &name, int start, int end);
+
+  //! remove group (areas are kept and group is deleted)
+  bool removeGroup(CQToolStripGroup *group);
+  bool removeGroup(const QString &name);
+
+  int numGroups() const { return int(groups_.size()); }
+
+  CQToolStripGroup *getGroup(int i) const { return groups_[uint(i)]; }
+  CQToolStripGroup *getGroup(const QString &name) const;
+
+  //! collapse/expand group to single button
+  void setGroupCollapsed(const QString &name, bool collapsed);
+
   void hideSplitters();
 
   CQToolStripSplitter *getSplitter();
@@ -39,32 +126,239 @@ class CQToolStrip : public QWidget {
 
   void updateLayout(bool updateSplitters);
 
+  //! get/set solve full layout on worker thread (if at least threshold areas)
+  //! previous layout is kept until the solve finishes
+  bool isAsyncLayout() const { return asyncLayout_; }
+  void setAsyncLayout(bool async);
+
+  int asyncLayoutThreshold() const { return asyncThreshold_; }
+  void setAsyncLayoutThreshold(int n) { asyncThreshold_ = n; }
+
+  //! get/set time budget (ms) per event loop iteration for applying full layout
+  //! (0 applies in one go). Visible areas are applied first.
+  int layoutBudget() const { return layoutBudget_; }
+  void setLayoutBudget(int ms);
+
+  //! is full layout being solved or applied
+  bool isLayoutPending() const;
+
+  //! get/set show overflow menu in lightweight popup window instead of QMenu
+  bool isPopupHost() const;
+  void setPopupHost(bool b);
+
+  //! time (ms) from menu button press to first paint of overflow menu (-1 if none)
+  double popupLatency() const { return popupLatency_; }
+
+  //! get overflow menu
+  CQToolStripMenu *menu() const { return menu_; }
+
+  //! get estimated memory used by strip (excludes shared menu scroll areas and metric cache)
+  MemoryStats memoryStats() const;
+
+  //! print memory stats (and shared menu and metric cache memory) to stream for debug
+  void dumpMemory(std::ostream &os) const;
+
+  //! get/set how areas which don't fit are shown
+  OverflowPolicy overflowPolicy() const { return overflowPolicy_; }
+  void setOverflowPolicy(OverflowPolicy policy);
+
+  //! get/set scroll position (scroll overflow policy)
+  int scrollPos() const { return scrollPos_; }
+  void setScrollPos(int pos);
+
+  //! get shared column width model (see CQToolStripColumnModel::addStrip)
+  CQToolStripColumnModel *columnModel() const { return columnModel_; }
+
+  //! save/restore user set area widths (keyed by area object name) and strip clipping
+  QByteArray saveState() const;
+  bool restoreState(const QByteArray &state);
+
   QSize sizeHint() const override;
   QSize minimumSizeHint() const override;
 
+  //! height for width of wrapped horizontal strip (cached per width)
+  bool hasHeightForWidth() const override;
+  int heightForWidth(int w) const override;
+
+  //! invalidate cached size hints (when area contents change)
+  void invalidateSizeHints();
+
+ signals:
+  //! emitted when full layout has been completely applied
+  void layoutSettled();
+
+  //! emitted after each layout pass which places areas (full, partial or progressive
+  //! step) with time (ms) spent in pass
+  void layoutApplied(double ms);
+
+  //! emitted when overflow menu is first painted after menu button press
+  void popupLatencyMeasured(double ms);
+
+  //! emitted when user drags splitter after area
+  void splitterDragged(int ind, int d);
+
  private:
-  void expandToFit(int ind=-1, int fitW=-1);
+  template<typename Axis, typename Spacing> friend class CQToolStripLayoutT;
+
+  friend class CQToolStripArea;
+  friend class CQToolStripGroup;
+  friend class CQToolStripMenu;
+  friend class CQToolStripMenuButton;
+  friend class CQToolStripColumnModel;
+  friend class CQToolStripRecorder;
+
+  void nestedSizeChanged(CQToolStripArea *area);
+
+  void requestAreaRelayout(CQToolStripArea *area);
+
+  void areaHiddenChanged(CQToolStripArea *area);
+
+  void invalidateSizeHintCache();
+
+  void areaLengthChanged(CQToolStripArea *area);
+
+  void areaClippedChanged(CQToolStripArea *area);
+
+  int firstClippedInd() const;
+
+  void invalidateSegments() { segmentsValid_ = false; invalidateRows(0); }
+
+  void invalidateRows(int ind);
+
+  bool hasCollapsedGroup() const;
+
+  void updateAreaGroup(int ind);
+
+  void groupRange(const CQToolStripGroup *group, int &start, int &end) const;
+
+  bool canSetAreaGroup(CQToolStripArea *area, CQToolStripGroup *group) const;
+
+  bool restoreClipInd(int &clipInd);
 
   void showEvent(QShowEvent *) override;
 
   void resizeEvent(QResizeEvent *) override;
 
-  int contentsWidth() const;
+  void wheelEvent(QWheelEvent *) override;
+
+  void mousePressEvent  (QMouseEvent *) override;
+  void mouseMoveEvent   (QMouseEvent *) override;
+  void mouseReleaseEvent(QMouseEvent *) override;
+
+  int contentsLength() const;
 
-  std::vector<int> getResizeInds() const;
+  int stripLength() const;
+
+  void updateLayoutFrom(int ind, bool full);
 
   void updateLabelHeight();
 
-  bool reduceSize();
+  bool useAsyncLayout() const;
+
+  CQToolStripLayoutInput layoutInput();
+
+  void requestAsyncLayout();
+
+  void applyLayoutResult(const CQToolStripLayoutResult &result);
+
+  void startProgressiveLayout(const CQToolStripLayoutResult &result);
+  void finishProgressiveLayout();
+  void cancelProgressiveLayout();
+  void dropProgressiveLayout();
 
-  void updateVisible();
+  void schedulePrewarm();
+
+  void setPopupLatency(double ms);
+
+  void emitLayoutApplied();
 
  private slots:
   void splitterMoved(int ind, int d);
 
+  void asyncLayoutSolved();
+
+  void progressiveLayoutStep();
+
+  void prewarmMenu();
+
+  void popupMenu();
+
+  void scrollBackSlot();
+  void scrollForwardSlot();
+
+  void areaRelayoutSlot();
+
+  void sizeHintsSlot();
+
  private:
   typedef std::vector<CQToolStripArea *>     AreaArray;
   typedef std::vector<CQToolStripSplitter *> Splitters;
+  typedef std::vector<CQToolStripGroup *>    Groups;
+
+  typedef CQToolStripLayoutResult                 LayoutResult;
+  typedef QFutureWatcher<CQToolStripLayoutResult> LayoutWatcher;
+
+  struct LayoutPass;
+
+  // clipping from last saved state (used for first layout if strip length matches)
+  struct RestoreData {
+    bool valid;
+    int  width;
+    int  numAreas;
+    int  clipInd;
+
+    RestoreData() {
+      valid    = false;
+      width    = -1;
+      numAreas = 0;
+      clipInd  = -1;
+    }
+  };
+
+  // drag of strip background (scroll overflow policy)
+  struct DragState {
+    bool pressed;
+    int  pressPos;
+    int  scrollPos;
+
+    DragState() {
+      pressed   = false;
+      pressPos  = 0;
+      scrollPos = 0;
+    }
+  };
+
+  // row of areas (wrap overflow policy)
+  struct Row {
+    int start;       // first area
+    int end;         // last area
+    int length;      // length of areas (including margin)
+    int labelHeight; // label height of areas
+    int breadth;     // breadth of areas
+
+    Row() {
+      start       = 0;
+      end         = -1;
+      length      = 0;
+      labelHeight = 0;
+      breadth     = 0;
+    }
+  };
+
+  typedef std::vector<Row> Rows;
+
+  typedef std::map<int, int> HeightForWidth;
+
+  // cached size hint
+  struct SizeHint {
+    bool  valid;
+    QSize size;
+    QSize prevSize; // size before last invalidate (parent only notified if changed)
+
+    SizeHint() {
+      valid = false;
+    }
+  };
 
   Qt::Orientation        orientation_;
   CQToolStripMenuButton *menuButton_;
@@ -73,6 +367,84 @@ class CQToolStrip : public QWidget {
   int                    splitterPos_;
   Splitters              splitters_;
   int                    labelHeight_;
+  bool                   clip_;
+  bool                   layoutDirty_;
+  QSize                  layoutSize_;
+  RestoreData            restoreData_;
+  mutable SizeHint       sizeHint_;
+  mutable SizeHint       minSizeHint_;
+  Groups                 groups_;
+  std::vector<int>       activeInds_;
+  CQToolStripSegmentTree lengths_;
+  CQToolStripGeometryTable geometry_;
+  bool                   segmentsValid_;
+  bool                   asyncLayout_;
+  int                    asyncThreshold_;
+  int                    layoutGeneration_;
+  LayoutWatcher         *layoutWatcher_;
+  AreaArray              layoutAreas_;
+  int                    layoutBudget_;
+  QTimer                *layoutTimer_;
+  LayoutResult          *pendingResult_;
+  std::vector<int>       pendingInds_;
+  int                    pendingPos_;
+  int                    pendingVisible_;
+  QTimer                *prewarmTimer_;
+  double                 popupLatency_;
+  OverflowPolicy         overflowPolicy_;
+  int                    scrollPos_;
+  int                    scrollRange_;
+  QToolButton           *scrollBackButton_;
+  QToolButton           *scrollForwardButton_;
+  DragState              dragState_;
+  Rows                   rows_;
+  int                    wrapBreadth_;
+  mutable HeightForWidth heightForWidth_;
+  CQToolStripColumnModel *columnModel_;
+  AreaArray              relayoutAreas_;
+  QTimer                *relayoutTimer_;
+  QTimer                *sizeHintTimer_;
+  QElapsedTimer          layoutPassTimer_;
+  int                    layoutPassDepth_;
+};
+
+//! named group of consecutive areas which is collapsed (to button) or clipped as one unit
+class CQToolStripGroup : public QObject {
+  Q_OBJECT
+
+ public:
+  CQToolStripGroup(CQToolStrip *strip, const QString &name);
+
+  CQToolStrip *strip() const { return strip_; }
+
+  const QString &name() const { return name_; }
+
+  //! get/set collapsed by user
+  bool isCollapsed() const { return collapsed_; }
+  void setCollapsed(bool collapsed);
+
+  //! is collapsed by user or by strip (to fit)
+  bool isShownCollapsed() const { return collapsed_ || autoCollapsed_; }
+
+  //! range of areas (-1 if no areas)
+  int startInd() const { return startInd_; }
+  int endInd  () const { return endInd_  ; }
+
+  CQToolStripGroupButton *button();
+
+  void hideButton();
+
+ private:
+  template<typename Axis, typename Spacing> friend class CQToolStripLayoutT;
+  friend class CQToolStrip;
+
+  CQToolStrip            *strip_;
+  QString                 name_;
+  bool                    collapsed_;
+  bool                    autoCollapsed_;
+  int                     startInd_;
+  int                     endInd_;
+  CQToolStripGroupButton *button_;
 };
 
 class CQToolStripArea : public QWidget {
@@ -89,27 +461,66 @@ class CQToolStripArea : public QWidget {
  public:
   CQToolStripArea(CQToolStrip *strip);
 
+  CQToolStrip *strip() const { return strip_; }
+
+  //! group area belongs to (if any). Groups must stay contiguous so area can only
+  //! join group next to it or leave at end of group (false if not allowed)
+  CQToolStripGroup *group() const { return group_; }
+  bool setGroup(CQToolStripGroup *group);
+
   QWidget *widget() const { return w_; }
   void setWidget(QWidget *w);
 
+  //! get/set factory to create widget when area is first shown (in strip or menu).
+  //! Area is hidden until placed and factory size hints are used until widget is created.
+  CQToolStripWidgetFactory *widgetFactory() const { return factory_; }
+  void setWidgetFactory(CQToolStripWidgetFactory *factory, const QString &id);
+
+  //! widget id passed to factory
+  const QString &widgetFactoryId() const { return factoryId_; }
+
+  //! widget is still to be created by factory
+  bool isWidgetPending() const { return factory_ && ! w_; }
+
+  //! create widget from factory (if pending)
+  void ensureWidget();
+
+  //! widget is a nested strip
+  CQToolStrip *nestedStrip() const { return qobject_cast<CQToolStrip *>(w_); }
+
   Flags flags() const { return flags_; }
   void setFlags(Flags flags);
 
   Qt::Alignment alignment() const { return alignment_; }
   void setAlignment(Qt::Alignment alignment);
 
+  const QString &labelText() const { return labelText_; }
   void setLabel(const QString &label);
   void unsetLabel();
 
   bool isResizable() const { return resizable_; }
   void setResizable(bool resizable);
 
+  //! get/set hidden by application (skipped by layout, never clipped to menu)
+  bool isHiddenByUser() const { return hiddenByUser_; }
+  void setHiddenByUser(bool hidden);
+
   int labelMinHeight() const;
   int labelHeight() const;
 
+  //! get/set display width (length along strip for vertical strip). Set width is a
+  //! user width (saved in strip state) until reset with -1
   int displayWidth() const;
   void setDisplayWidth(int w);
 
+  bool hasDisplayWidth() const { return displayWidth_ >= 0; }
+
+  //! display width last set by user (splitter drag or setDisplayWidth) rather than
+  //! layout (-1 if none). Layout may since have shrunk the display width
+  int userWidth() const { return userWidth_; }
+
+  bool hasUserWidth() const { return userWidth_ >= 0; }
+
   void updateLayout();
 
   void setClipped(bool clipped);
@@ -118,18 +529,44 @@ class CQToolStripArea : public QWidget {
   QSize sizeHint() const override;
   QSize minimumSizeHint() const override;
 
+  //! size hints when in overflow menu (label not aligned with strip)
+  QSize menuSizeHint() const;
+  QSize menuMinimumSizeHint() const;
+
  private:
+  template<typename Axis, typename Spacing> friend class CQToolStripLayoutT;
+  friend class CQToolStrip;
+  friend class CQToolStripColumnModel;
+
+  // set display width calculated by layout (not user width)
+  void setLayoutWidth(int w);
+
+  QSize labelSize() const;
+
+  QSize calcSizeHint(int lh) const;
+  QSize calcMinimumSizeHint(int lh) const;
+
+  bool event(QEvent *e) override;
+
   void resizeEvent(QResizeEvent *) override;
 
  private:
-  CQToolStrip   *strip_;
-  QWidget       *w_;
-  Flags          flags_;
-  Qt::Alignment  alignment_;
-  QLabel        *label_;
-  bool           resizable_;
-  int            displayWidth_;
-  bool           clipped_;
+  CQToolStrip      *strip_;
+  CQToolStripGroup *group_;
+  int               index_;
+  QWidget          *w_;
+  Flags             flags_;
+  Qt::Alignment     alignment_;
+  QLabel           *label_;
+  QString           labelText_;
+  bool              resizable_;
+  int               displayWidth_;
+  int               userWidth_;
+  bool              clipped_;
+  int               rowLabelHeight_;
+  bool              hiddenByUser_;
+  CQToolStripWidgetFactory *factory_;
+  QString           factoryId_;
 };
 
 class CQToolStripSplitter : public QWidget {
@@ -176,31 +613,84 @@ class CQToolStripMenuButton : public QToolButton {
  public:
   CQToolStripMenuButton(CQToolStrip *strip);
 
+  void updateIcon();
+
  private:
+  void mousePressEvent(QMouseEvent *e) override;
+
   void paintEvent(QPaintEvent *) override;
 
  private:
   CQToolStrip *strip_;
 };
 
+//! button for collapsed group (popup menu shows group areas)
+class CQToolStripGroupButton : public QToolButton {
+  Q_OBJECT
+
+ public:
+  CQToolStripGroupButton(CQToolStripGroup *group);
+
+ private:
+  CQToolStripGroup *group_;
+};
+
 class CQToolStripMenuContents;
 
 class CQToolStripMenu : public CQFrameMenu {
   Q_OBJECT
 
  public:
-  CQToolStripMenu(CQToolStrip *strip);
+  CQToolStripMenu(CQToolStrip *strip, CQToolStripGroup *group=0);
 
   CQToolStrip *strip() const { return strip_; }
 
+  //! group menu (shows group areas instead of clipped areas)
+  CQToolStripGroup *group() const { return group_; }
+
  public slots:
   void addActions();
   void removeActions();
 
+ public:
+  void clearActions();
+
+  void removeArea(CQToolStripArea *area);
+
+  void updateContents();
+
+  //! calculate menu areas and contents size before menu is shown
+  void prewarm();
+  void invalidatePrewarm() { prewarmed_ = false; }
+
+  //! start timing menu show (stopped on first paint)
+  void startLatencyTimer();
+
+  //! time (ms) of strip relayout after last close (when phase timing enabled)
+  double relayoutTime() const { return relayoutTime_; }
+
+  //! estimated bytes used by menu areas and search index
+  size_t memoryBytes() const;
+
  private:
+  friend class CQToolStripMenuContents;
+
+  void updateSearchIndex();
+
+  void popupPaintEvent() override;
+
+ private:
+  typedef std::vector<CQToolStripArea *> Areas;
+
   CQToolStrip             *strip_;
+  CQToolStripGroup        *group_;
   CQToolStripMenuContents *contents_;
   QVBoxLayout             *layout_;
+  Areas                    prewarmAreas_;
+  CQToolStripSearchIndex   searchIndex_;
+  bool                     prewarmed_;
+  QElapsedTimer            latencyTimer_;
+  double                   relayoutTime_;
 };
 
 class CQToolStripMenuContents : public QWidget {
@@ -213,6 +703,22 @@ class CQToolStripMenuContents : public QWidget {
 
   void removeAreas(QWidget *parent);
 
+  void removeArea(CQToolStripArea *area);
+
+  void updateAreas();
+
+  //! clear search (all menu areas shown)
+  void resetFilter();
+
+  //! minimum size for areas (and search field)
+  QSize areasMinimumSize(const std::vector<CQToolStripArea *> &areas) const;
+
+  //! estimated bytes used by area and match lists
+  size_t memoryBytes() const;
+
+ private slots:
+  void filterSlot(const QString &text);
+
  private:
   void showEvent(QShowEvent *) override;
   void resizeEvent(QResizeEvent *) override;
@@ -224,7 +730,13 @@ class CQToolStripMenuContents : public QWidget {
 
  private:
   typedef std::vector<CQToolStripArea *> Areas;
+  typedef CQToolStripSearchIndex::Inds   Inds;
 
   CQToolStripMenu *menu_;
   Areas            areas_;
+  QLineEdit       *search_;
+  QString          filter_;
+  Inds             matches_;
 };
+
+#endif
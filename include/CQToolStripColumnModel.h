@@ -0,0 +1,69 @@
+#ifndef CQToolStripColumnModel_H
+#define CQToolStripColumnModel_H
+
+/*!
+ * Column widths shared by stacked strips.
+ *
+ * Area i of each attached strip is in column i. A single solve computes each column
+ * width (the largest area width in the column, or the user set width, shrunk to fit
+ * the shortest strip) and all strips are then laid out once with those widths. A
+ * splitter drag in any strip sets the column width for all strips.
+ */
+
+#include <QObject>
+#include <vector>
+
+class CQToolStrip;
+class QTimer;
+
+class CQToolStripColumnModel : public QObject {
+  Q_OBJECT
+
+ public:
+  CQToolStripColumnModel(QObject *parent=0);
+ ~CQToolStripColumnModel();
+
+  //! add/remove strip (strip is not owned by model)
+  void addStrip(CQToolStrip *strip);
+  void removeStrip(CQToolStrip *strip);
+
+  int numStrips() const { return int(strips_.size()); }
+
+  CQToolStrip *strip(int i) const { return strips_[uint(i)]; }
+
+  int numColumns() const { return int(widths_.size()); }
+
+  int columnWidth(int i) const { return widths_[uint(i)]; }
+
+  //! set user width of column (-1 for default)
+  void setColumnWidth(int i, int w);
+
+  //! resize column from splitter drag in strip
+  void splitterMoved(CQToolStrip *strip, int ind, int d);
+
+  //! solve column widths and layout all strips
+  void updateColumns();
+
+  //! solve and layout on next event loop iteration (coalesces changes)
+  void scheduleUpdate();
+
+ signals:
+  void columnsChanged();
+
+ private slots:
+  void stripDestroyed(QObject *obj);
+
+  void updateSlot();
+
+ private:
+  typedef std::vector<CQToolStrip *> Strips;
+  typedef std::vector<int>           Widths;
+
+  Strips  strips_;
+  Widths  userWidths_; // user set column widths (-1 if not set)
+  Widths  widths_;     // solved column widths
+  Widths  minWidths_;  // minimum column widths
+  QTimer *timer_;
+};
+
+#endif
@@ -0,0 +1,191 @@
+#ifndef CQToolStripGeometryTable_H
+#define CQToolStripGeometryTable_H
+
+#include <CQToolStripMemory.h>
+#include <vector>
+#include <algorithm>
+
+/*!
+ * Structure of arrays copy of area layout state (length along strip, minimum length,
+ * splitter length and flags) with area offsets.
+ *
+ * Layout scans (clipping, resizable areas) read these contiguous arrays instead of
+ * each area widget. Offsets are an exclusive prefix sum of the area extents which is
+ * only recalculated from the first changed area. Scan kernels test a block of areas
+ * at a time without branches so the compiler can vectorize them.
+ */
+
+class CQToolStripGeometryTable {
+ public:
+  enum Flags {
+    NoFlags   = 0,
+    Hidden    = (1<<0), //!< hidden by user (zero extent)
+    Resizable = (1<<1),
+    Nested    = (1<<2), //!< area contains nested strip
+    Grouped   = (1<<3), //!< area is in group
+    Clipped   = (1<<4)  //!< area is clipped (in overflow menu)
+  };
+
+ public:
+  CQToolStripGeometryTable() :
+   n_(0), gap_(0), dirty_(0) {
+  }
+
+  //! clear and size for n areas with gap after each area
+  void reset(int n, int gap) {
+    n_   = n;
+    gap_ = gap;
+
+    auto un = uint(n);
+
+    lengths_   .assign(un, 0);
+    minLengths_.assign(un, 0);
+    splitters_ .assign(un, 0);
+    extents_   .assign(un, 0);
+    ends_      .assign(un, 0);
+    flags_     .assign(un, 0);
+    offsets_   .assign(un + 1, 0);
+
+    dirty_ = 0;
+  }
+
+  int size() const { return n_; }
+
+  //! set area values (extent is length plus gap and splitter, zero if hidden)
+  void setArea(int i, int length, int minLength, int splitter, unsigned int flags) {
+    auto ui = uint(i);
+
+    int extent = ((flags & Hidden) ? 0 : length + gap_ + splitter);
+
+    if (extent != extents_[ui] || splitter != splitters_[ui])
+      dirty_ = std::min(dirty_, i);
+
+    lengths_   [ui] = length;
+    minLengths_[ui] = minLength;
+    splitters_ [ui] = splitter;
+    extents_   [ui] = extent;
+    flags_     [ui] = static_cast<unsigned char>(flags);
+  }
+
+  int length   (int i) const { return lengths_   [uint(i)]; }
+  int minLength(int i) const { return minLengths_[uint(i)]; }
+  int splitter (int i) const { return splitters_ [uint(i)]; }
+  int extent   (int i) const { return extents_   [uint(i)]; }
+
+  unsigned int flags(int i) const { return flags_[uint(i)]; }
+
+  bool hasFlag(int i, Flags flag) const { return (flags_[uint(i)] & flag); }
+
+  void setFlag(int i, Flags flag, bool set) {
+    if (set)
+      flags_[uint(i)] |=  static_cast<unsigned char>(flag);
+    else
+      flags_[uint(i)] &= ~static_cast<unsigned char>(flag);
+  }
+
+  //! extents of all areas
+  const std::vector<int> &extents() const { return extents_; }
+
+  //! offset of area from first area (offset of size() is total extent)
+  int offset(int i) const {
+    ensureOffsets();
+
+    return offsets_[uint(i)];
+  }
+
+  //! index of first area whose end (offset plus length and gap) is past limit
+  //! (size() if none)
+  int firstExceeding(int limit) const {
+    ensureOffsets();
+
+    const int *ends = ends_.data();
+
+    int i = 0;
+
+    for ( ; i + blockSize <= n_; i += blockSize) {
+      int found = 0;
+
+      for (int k = 0; k < blockSize; ++k)
+        found |= (ends[i + k] > limit);
+
+      if (found) break;
+    }
+
+    for ( ; i < n_; ++i) {
+      if (ends[i] > limit)
+        return i;
+    }
+
+    return n_;
+  }
+
+  //! index of first area with flag (size() if none)
+  int firstFlag(Flags flag) const {
+    const unsigned char *flags = flags_.data();
+
+    int i = 0;
+
+    for ( ; i + blockSize <= n_; i += blockSize) {
+      unsigned int found = 0;
+
+      for (int k = 0; k < blockSize; ++k)
+        found |= flags[i + k];
+
+      if (found & flag) break;
+    }
+
+    for ( ; i < n_; ++i) {
+      if (flags[i] & flag)
+        return i;
+    }
+
+    return n_;
+  }
+
+  //! bytes used by arrays
+  size_t memoryBytes() const {
+    using namespace CQToolStripMemory;
+
+    return vectorBytes(lengths_) + vectorBytes(minLengths_) + vectorBytes(splitters_) +
+           vectorBytes(extents_) + vectorBytes(ends_) + vectorBytes(offsets_) +
+           vectorBytes(flags_);
+  }
+
+ private:
+  // update offsets and ends from first changed area
+  void ensureOffsets() const {
+    if (dirty_ >= n_)
+      return;
+
+    int *offsets = offsets_.data();
+    int *ends    = ends_   .data();
+
+    const int *extents   = extents_  .data();
+    const int *splitters = splitters_.data();
+
+    // prefix sum (serial) then ends (vectorizable)
+    for (int i = dirty_; i < n_; ++i)
+      offsets[i + 1] = offsets[i] + extents[i];
+
+    for (int i = dirty_; i < n_; ++i)
+      ends[i] = offsets[i + 1] - splitters[i];
+
+    dirty_ = n_;
+  }
+
+ private:
+  static constexpr int blockSize = 16; // areas compared per branch
+
+  int                         n_;
+  int                         gap_;
+  std::vector<int>            lengths_;    // display length along strip
+  std::vector<int>            minLengths_; // minimum length along strip
+  std::vector<int>            splitters_;  // length of following splitter
+  std::vector<int>            extents_;    // length plus gap and splitter (0 if hidden)
+  std::vector<unsigned char>  flags_;
+  mutable std::vector<int>    offsets_;    // exclusive prefix sum of extents
+  mutable std::vector<int>    ends_;       // offset plus extent minus splitter
+  mutable int                 dirty_;      // first area with invalid offset
+};
+
+#endif
@@ -0,0 +1,27 @@
+#ifndef CQToolStripMemory_H
+#define CQToolStripMemory_H
+
+/*!
+ * Heap usage estimates of containers (used by all memoryBytes estimates).
+ */
+
+#include <QString>
+#include <vector>
+
+namespace CQToolStripMemory {
+
+// std::map/std::set node overhead is three pointers and color
+const size_t mapNodeBytes = 4*sizeof(void *);
+
+template<typename T>
+size_t vectorBytes(const std::vector<T> &v) {
+  return v.capacity()*sizeof(T);
+}
+
+inline size_t stringBytes(const QString &s) {
+  return size_t(s.capacity())*sizeof(QChar);
+}
+
+}
+
+#endif
@@ -0,0 +1,144 @@
+#ifndef CQToolStripMetricCache_H
+#define CQToolStripMetricCache_H
+
+/*!
+ * Process wide cache of minimum and preferred sizes for standard widgets.
+ *
+ * Strips often contain many identical widgets (tool buttons, line edits) so the size
+ * of a widget is stored against a key built from its class, font, style, device pixel
+ * ratio and contents (text, icon size, ...). Only exact instances of known Qt widget
+ * classes (and area labels) are cached as sub classes may override the size hints.
+ *
+ * The cache can be saved to and loaded from a persistent file so the first layout of
+ * the next run needs no widget measurement. The file is memory mapped (entries are
+ * looked up in place) and is ignored if the application font, style, screen DPI or
+ * cache version differ from when it was saved. Sizes from the file are checked by
+ * measuring the widget in idle time and widgets with changed sizes are updated.
+ *
+ * Keys include widget text so the number of entries is limited. When the limit is
+ * reached the least recently used half of the entries are removed.
+ *
+ * The cache is disabled by default.
+ */
+
+#include <QObject>
+#include <QPointer>
+#include <QSize>
+#include <QString>
+#include <vector>
+#include <set>
+#include <map>
+
+class QWidget;
+class QLabel;
+class QFile;
+class QTimer;
+
+class CQToolStripMetricCache : public QObject {
+  Q_OBJECT
+
+ public:
+  struct Metrics {
+    QSize minSize;
+    QSize sizeHint;
+  };
+
+ public:
+  static CQToolStripMetricCache *instance();
+
+  //! get/set enabled
+  bool isEnabled() const { return enabled_; }
+  void setEnabled(bool enabled);
+
+  //! get key for widget (empty if widget can't be cached)
+  QString widgetKey(const QWidget *w) const;
+
+  //! get key for area label (empty if label can't be cached)
+  QString labelKey(const QLabel *label) const;
+
+  //! lookup/add metrics for key
+  bool lookup(const QString &key, Metrics &metrics) const;
+  void insert(const QString &key, const Metrics &metrics);
+
+  //! get widget metrics (from cache if possible)
+  Metrics widgetMetrics(QWidget *w);
+
+  //! get label minimum size (from cache if possible)
+  QSize labelSize(QLabel *label);
+
+  void clear();
+
+  int size() const { return int(metrics_.size()); }
+
+  //! get/set maximum number of entries (least recently used are removed)
+  int maxSize() const { return maxSize_; }
+  void setMaxSize(int n);
+
+  int numHits  () const { return numHits_  ; }
+  int numMisses() const { return numMisses_; }
+
+  //! estimated bytes used by keys and metrics
+  size_t memoryBytes() const;
+
+  //! load persistent cache file (false if missing or saved for different environment)
+  bool load(const QString &filename);
+
+  //! save cache (and entries of loaded file) for current environment
+  bool save(const QString &filename);
+
+  //! unmap loaded file
+  void unload();
+
+  //! number of entries in loaded file and number of lookups found in file
+  int fileSize   () const { return numFileEntries_; }
+  int numFileHits() const { return numFileHits_; }
+
+ private slots:
+  void verifySlot();
+
+ private:
+  struct FileEntry;
+
+  CQToolStripMetricCache();
+
+  Metrics cachedMetrics(QWidget *w, const QString &key);
+
+  static Metrics measure(QWidget *w, bool label);
+
+  static quint64 keyHash(const QString &key);
+
+  static quint64 environmentHash();
+
+  bool lookupFile(const QString &key, Metrics &metrics) const;
+
+  void addVerify(QWidget *w, const QString &key);
+
+  void trim(int n);
+
+ private:
+  struct Entry {
+    Metrics         metrics;
+    mutable quint64 used; // use count when last looked up
+  };
+
+  typedef std::map<QString, Entry>              KeyMetrics;
+  typedef std::pair<QPointer<QWidget>, QString> VerifyWidget;
+  typedef std::vector<VerifyWidget>             VerifyWidgets;
+
+  bool                      enabled_;
+  KeyMetrics                metrics_;
+  int                       maxSize_;
+  mutable quint64           useCount_;
+  int                       numHits_;
+  int                       numMisses_;
+  QFile                    *file_;              // loaded (mapped) file
+  const FileEntry          *fileEntries_;       // mapped entries (sorted by key hash)
+  int                       numFileEntries_;
+  int                       numFileHits_;
+  std::set<QString>         unverified_;        // keys with metrics from file
+  VerifyWidgets             verifyWidgets_;     // widgets sized from unverified metrics
+  std::set<const QWidget *> verifyQueued_;
+  QTimer                   *verifyTimer_;
+};
+
+#endif
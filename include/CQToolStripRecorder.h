@@ -0,0 +1,135 @@
+#ifndef CQToolStripRecorder_H
+#define CQToolStripRecorder_H
+
+/*!
+ * Record interaction with a strip (window resizes, splitter drags, overflow menu
+ * open/close and menu border drags) to a compact binary file for replay.
+ *
+ * The recording starts with a description of the strip (orientation, overflow policy,
+ * popup host mode, window size, groups and the metrics of each area as measured by the
+ * layout) so a replay can rebuild an identical strip from placeholder widgets without
+ * the application. Events are stored with the time (ms) since the recording started.
+ */
+
+#include <QObject>
+#include <QElapsedTimer>
+#include <QSize>
+#include <QString>
+#include <vector>
+
+class CQToolStrip;
+
+struct CQToolStripRecording {
+  enum EventType {
+    ResizeEvent    = 1, // window width, height
+    SplitterEvent  = 2, // area index, delta
+    MenuOpenEvent  = 3,
+    MenuCloseEvent = 4,
+    MenuRectEvent  = 5  // left, bottom, right, top deltas
+  };
+
+  struct Area {
+    QString label;
+    QString className;    // class of area widget (for reporting)
+    bool    resizable;
+    bool    hidden;       // hidden by user
+    bool    nested;       // widget is nested strip
+    int     displayWidth; // user set width (-1 if not set)
+    QSize   minSize;      // widget metrics used by layout
+    QSize   sizeHint;
+
+    Area() :
+     resizable(false), hidden(false), nested(false), displayWidth(-1) {
+    }
+  };
+
+  struct Group {
+    QString name;
+    int     start;
+    int     end;
+    bool    collapsed; // collapsed by user
+
+    Group() :
+     start(-1), end(-1), collapsed(false) {
+    }
+  };
+
+  struct Event {
+    EventType type;
+    quint32   time;      // ms since start of recording
+    qint32    values[4];
+
+    Event(EventType type=ResizeEvent, quint32 time=0, int v1=0, int v2=0, int v3=0, int v4=0) :
+     type(type), time(time) {
+      values[0] = v1; values[1] = v2; values[2] = v3; values[3] = v4;
+    }
+  };
+
+  typedef std::vector<Area>  Areas;
+  typedef std::vector<Group> Groups;
+  typedef std::vector<Event> Events;
+
+  Qt::Orientation orientation;
+  int             overflowPolicy; // CQToolStrip::OverflowPolicy
+  bool            popupHost;
+  QSize           windowSize;
+  Areas           areas;
+  Groups          groups;
+  Events          events;
+
+  CQToolStripRecording() :
+   orientation(Qt::Horizontal), overflowPolicy(0), popupHost(false) {
+  }
+
+  bool save(const QString &filename) const;
+  bool load(const QString &filename);
+
+  static const char *eventName(EventType type);
+};
+
+class CQToolStripRecorder : public QObject {
+  Q_OBJECT
+
+ public:
+  CQToolStripRecorder(CQToolStrip *strip);
+
+  CQToolStrip *strip() const { return strip_; }
+
+  //! start recording (records current strip state)
+  void start();
+
+  //! stop recording
+  void stop();
+
+  bool isRecording() const { return recording_; }
+
+  const CQToolStripRecording &recording() const { return data_; }
+
+  //! save recording to file
+  bool save(const QString &filename) const { return data_.save(filename); }
+
+  //! apply recorded event to strip (replay)
+  static void applyEvent(CQToolStrip *strip, const CQToolStripRecording::Event &event);
+
+ private slots:
+  void splitterSlot(int ind, int d);
+
+  void menuOpenSlot();
+  void menuCloseSlot();
+
+  void menuRectSlot(int dxl, int dyb, int dxr, int dyt);
+
+ private:
+  bool eventFilter(QObject *o, QEvent *e) override;
+
+  void addEvent(CQToolStripRecording::EventType type, int v1=0, int v2=0, int v3=0, int v4=0);
+
+ private:
+  CQToolStrip          *strip_;
+  QWidget              *window_;
+  bool                  recording_;
+  QElapsedTimer         timer_;
+  CQToolStripRecording  data_;
+};
+
+#endif
@@ -0,0 +1,44 @@
+#ifndef CQToolStripSearchIndex_H
+#define CQToolStripSearchIndex_H
+
+/*!
+ * Case insensitive substring search over a fixed list of strings.
+ *
+ * Each string is split into trigrams (3 character substrings). The candidates for a
+ * search string are the strings of its trigram with the shortest list (none if any of
+ * its trigrams is missing) and each candidate is then checked for the search string.
+ * Searches shorter than a trigram check all strings (or the previous matches).
+ */
+
+#include <QString>
+#include <vector>
+#include <map>
+
+class CQToolStripSearchIndex {
+ public:
+  typedef std::vector<int> Inds;
+
+ public:
+  void build(const std::vector<QString> &strs);
+
+  void clear();
+
+  int size() const { return int(strs_.size()); }
+
+  //! estimated bytes used by strings and trigram lists
+  size_t memoryBytes() const;
+
+  //! get indices of strings containing text (all if empty)
+  Inds match(const QString &text) const;
+
+  //! get indices from candidates (sorted) of strings containing text
+  Inds match(const QString &text, const Inds &candidates) const;
+
+ private:
+  typedef std::map<QString, Inds> Trigrams;
+
+  std::vector<QString> strs_;     // lower case strings
+  Trigrams             trigrams_; // sorted string indices for each trigram
+};
+
+#endif
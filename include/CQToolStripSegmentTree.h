@@ -0,0 +1,79 @@
+#ifndef CQToolStripSegmentTree_H
+#define CQToolStripSegmentTree_H
+
+#include <CQToolStripMemory.h>
+#include <vector>
+
+/*!
+ * Sum segment tree of area lengths.
+ *
+ * Changing one value or summing a range of values (e.g. the areas of a group) is O(log n).
+ */
+
+class CQToolStripSegmentTree {
+ public:
+  CQToolStripSegmentTree() :
+   n_(0), size_(0) {
+  }
+
+  void build(const std::vector<int> &values) {
+    n_ = int(values.size());
+
+    // round leaf count up to power of 2 so root is total
+    size_ = 1;
+
+    while (size_ < n_)
+      size_ *= 2;
+
+    tree_.assign(uint(2*size_), 0);
+
+    for (int i = 0; i < n_; ++i)
+      tree_[uint(size_ + i)] = values[uint(i)];
+
+    for (int i = size_ - 1; i > 0; --i)
+      tree_[uint(i)] = tree_[uint(2*i)] + tree_[uint(2*i + 1)];
+  }
+
+  int size() const { return n_; }
+
+  int value(int i) const { return tree_[uint(size_ + i)]; }
+
+  void setValue(int i, int value) {
+    int j = size_ + i;
+
+    tree_[uint(j)] = value;
+
+    for (j /= 2; j > 0; j /= 2)
+      tree_[uint(j)] = tree_[uint(2*j)] + tree_[uint(2*j + 1)];
+  }
+
+  //! sum of values from start to end (inclusive)
+  int sum(int start, int end) const {
+    int s = 0;
+
+    int l = size_ + start;
+    int r = size_ + end + 1;
+
+    while (l < r) {
+      if (l & 1) s += tree_[uint(l++)];
+      if (r & 1) s += tree_[uint(--r)];
+
+      l /= 2;
+      r /= 2;
+    }
+
+    return s;
+  }
+
+  int total() const { return (n_ > 0 ? tree_[1] : 0); }
+
+  //! bytes used by tree values
+  size_t memoryBytes() const { return CQToolStripMemory::vectorBytes(tree_); }
+
+ private:
+  int              n_;
+  int              size_;
+  std::vector<int> tree_;
+};
+
+#endif
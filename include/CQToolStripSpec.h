@@ -0,0 +1,92 @@
+#ifndef CQToolStripSpec_H
+#define CQToolStripSpec_H
+
+/*!
+ * Declarative strip description (loaded from JSON) with widgets created on demand.
+ *
+ * Each item names a registered widget factory. Areas are added to the strip in one
+ * batch (single layout) and use the size hints of the factory until the widget is
+ * created, which is when the area is first shown (in the strip or overflow menu).
+ *
+ * JSON format:
+ *
+ *   { "orientation": "horizontal",
+ *     "areas": [ { "id": "find", "label": "Find", "factory": "lineedit",
+ *                  "resizable": true, "priority": 1, "width": 120 }, ... ] }
+ */
+
+#include <QSize>
+#include <QString>
+#include <vector>
+
+class CQToolStrip;
+class CQToolStripArea;
+class QWidget;
+
+//! create area widgets (identified by item id) when needed
+class CQToolStripWidgetFactory {
+ public:
+  virtual ~CQToolStripWidgetFactory() { }
+
+  //! create widget for item id
+  virtual QWidget *createWidget(const QString &id) = 0;
+
+  //! size hints used by layout until widget is created
+  virtual QSize sizeHint(const QString &id) const = 0;
+  virtual QSize minimumSizeHint(const QString &id) const { return sizeHint(id); }
+};
+
+class CQToolStripSpec {
+ public:
+  struct Item {
+    QString id;        //!< area object name (and widget id passed to factory)
+    QString label;     //!< area label (none if empty)
+    QString factory;   //!< registered factory key
+    bool    resizable;
+    int     priority;  //!< application priority (not used by strip)
+    int     width;     //!< initial display width (-1 for default)
+
+    Item() :
+     resizable(false), priority(0), width(-1) {
+    }
+  };
+
+  typedef std::vector<Item>              Items;
+  typedef std::vector<CQToolStripArea *> Areas;
+
+ public:
+  CQToolStripSpec();
+
+  //! register factory for key (factory is not owned)
+  static void registerFactory(const QString &key, CQToolStripWidgetFactory *factory);
+  static void unregisterFactory(const QString &key);
+
+  static CQToolStripWidgetFactory *factory(const QString &key);
+
+  //! get/set orientation
+  Qt::Orientation orientation() const { return orientation_; }
+  void setOrientation(Qt::Orientation orientation) { orientation_ = orientation; }
+
+  const Items &items() const { return items_; }
+
+  void addItem(const Item &item) { items_.push_back(item); }
+
+  void clear() { items_.clear(); }
+
+  //! parse JSON text or file (false on error, see errorString)
+  bool parse(const QByteArray &json);
+  bool load(const QString &filename);
+
+  const QString &errorString() const { return errorString_; }
+
+  //! set strip orientation and add areas for items in one batch (items with
+  //! unregistered factory have no widget)
+  Areas apply(CQToolStrip *strip) const;
+
+ private:
+  Qt::Orientation orientation_;
+  Items           items_;
+  QString         errorString_;
+};
+
+#endif
@@ -0,0 +1,230 @@
+#include <CQToolStripReplay.h>
+#include <CQToolStrip.h>
+#include <QApplication>
+#include <QVBoxLayout>
+#include <QEventLoop>
+#include <QTimer>
+#include <iostream>
+#include <algorithm>
+#include <cstring>
+
+// placeholder for recorded area widget (same size hints)
+class ReplayWidget : public QWidget {
+ public:
+  ReplayWidget(const QSize &minSize, const QSize &sizeHint) :
+   minSize_(minSize), sizeHint_(sizeHint) {
+  }
+
+  QSize sizeHint() const override { return sizeHint_; }
+
+  QSize minimumSizeHint() const override { return minSize_; }
+
+ private:
+  QSize minSize_;
+  QSize sizeHint_;
+};
+
+// placeholder for recorded nested strip (same size hints, no areas)
+class ReplayStrip : public CQToolStrip {
+ public:
+  ReplayStrip(const QSize &minSize, const QSize &sizeHint) :
+   minSize_(minSize), sizeHint_(sizeHint) {
+  }
+
+  QSize sizeHint() const override { return sizeHint_; }
+
+  QSize minimumSizeHint() const override { return minSize_; }
+
+ private:
+  QSize minSize_;
+  QSize sizeHint_;
+};
+
+int
+main(int argc, char **argv)
+{
+  bool    show     = false;
+  bool    realTime = false;
+  QString filename;
+
+  for (int i = 1; i < argc; ++i) {
+    if      (strcmp(argv[i], "-show") == 0)
+      show = true;
+    else if (strcmp(argv[i], "-realtime") == 0)
+      realTime = true;
+    else if (argv[i][0] != '-')
+      filename = argv[i];
+  }
+
+  if (filename == "") {
+    std::cerr << "Usage: CQToolStripReplay [-show] [-realtime] <file>" << std::endl;
+    return 1;
+  }
+
+  // replay offscreen unless shown (same result on any machine)
+  if (! show && qgetenv("QT_QPA_PLATFORM").isEmpty())
+    qputenv("QT_QPA_PLATFORM", "offscreen");
+
+  QApplication app(argc, argv);
+
+  CQToolStripRecording recording;
+
+  if (! recording.load(filename)) {
+    std::cerr << "Failed to load '" << filename.toStdString() << "'" << std::endl;
+    return 1;
+  }
+
+  CQToolStripReplay replay(recording);
+
+  replay.setRealTime(realTime);
+
+  replay.exec();
+
+  return 0;
+}
+
+CQToolStripReplay::
+CQToolStripReplay(const CQToolStripRecording &recording) :
+ recording_(recording), realTime_(false)
+{
+  window_ = new QWidget;
+
+  QVBoxLayout *layout = new QVBoxLayout(window_);
+  layout->setContentsMargins(0, 0, 0, 0); layout->setSpacing(0);
+
+  strip_ = new CQToolStrip;
+
+  strip_->setOrientation(recording_.orientation);
+
+  strip_->setOverflowPolicy(CQToolStrip::OverflowPolicy(recording_.overflowPolicy));
+  strip_->setPopupHost(recording_.popupHost);
+
+  for (const auto &rarea : recording_.areas) {
+    QWidget *w;
+
+    if (rarea.nested)
+      w = new ReplayStrip(rarea.minSize, rarea.sizeHint);
+    else
+      w = new ReplayWidget(rarea.minSize, rarea.sizeHint);
+
+    CQToolStripArea *area;
+
+    if (rarea.label != "")
+      area = strip_->addWidget(rarea.label, w);
+    else
+      area = strip_->addWidget(w);
+
+    area->setResizable(rarea.resizable);
+
+    if (rarea.displayWidth >= 0)
+      area->setDisplayWidth(rarea.displayWidth);
+
+    area->setHiddenByUser(rarea.hidden);
+  }
+
+  for (const auto &rgroup : recording_.groups) {
+    auto *group = strip_->addGroup(rgroup.name, rgroup.start, rgroup.end);
+
+    if (group)
+      group->setCollapsed(rgroup.collapsed);
+  }
+
+  layout->addWidget(strip_);
+  layout->addStretch();
+
+  connect(strip_, SIGNAL(layoutApplied(double)), this, SLOT(layoutAppliedSlot(double)));
+
+  window_->resize(recording_.windowSize);
+}
+
+void
+CQToolStripReplay::
+exec()
+{
+  // initial show (not timed)
+  window_->show();
+
+  processEvents();
+
+  //---
+
+  int ne = int(recording_.events.size());
+
+  std::cout << recording_.areas.size() << " areas, " << ne << " events" << std::endl;
+  std::cout << "event\ttime\ttype\ttotal_ms\tpasses\tpass_ms" << std::endl;
+
+  QElapsedTimer timer;
+
+  timer.start();
+
+  double totalTime = 0.0, maxTime = 0.0, maxPass = 0.0;
+  int    numPasses = 0;
+
+  for (int i = 0; i < ne; ++i) {
+    const auto &event = recording_.events[uint(i)];
+
+    // wait for event time (handling events while waiting)
+    if (realTime_) {
+      qint64 wait = qint64(event.time) - timer.elapsed();
+
+      if (wait > 0) {
+        QEventLoop loop;
+
+        QTimer::singleShot(int(wait), &loop, SLOT(quit()));
+
+        loop.exec();
+      }
+    }
+
+    passes_.clear();
+
+    QElapsedTimer eventTimer;
+
+    eventTimer.start();
+
+    CQToolStripRecorder::applyEvent(strip_, event);
+
+    // include deferred (coalesced) layouts triggered by event
+    processEvents();
+
+    double t = eventTimer.nsecsElapsed()/1e6;
+
+    std::cout << i << "\t" << event.time << "\t" <<
+                 CQToolStripRecording::eventName(event.type) << "\t" << t << "\t" <<
+                 passes_.size() << "\t";
+
+    for (uint j = 0; j < passes_.size(); ++j) {
+      if (j > 0) std::cout << ",";
+
+      std::cout << passes_[j];
+
+      maxPass = std::max(maxPass, passes_[j]);
+    }
+
+    std::cout << std::endl;
+
+    totalTime += t;
+    maxTime    = std::max(maxTime, t);
+    numPasses += int(passes_.size());
+  }
+
+  std::cout << "total_ms " << totalTime << " mean_ms " << (ne > 0 ? totalTime/ne : 0.0) <<
+               " max_ms " << maxTime << " passes " << numPasses <<
+               " max_pass_ms " << maxPass << std::endl;
+}
+
+void
+CQToolStripReplay::
+processEvents()
+{
+  QCoreApplication::sendPostedEvents();
+  QCoreApplication::processEvents();
+}
+
+// time spent in layout pass (measured by strip)
+void
+CQToolStripReplay::
+layoutAppliedSlot(double ms)
+{
+  passes_.push_back(ms);
+}
@@ -0,0 +1,35 @@
+#include <CQToolStripRecorder.h>
+#include <QElapsedTimer>
+#include <vector>
+
+class CQToolStrip;
+class QWidget;
+
+class CQToolStripReplay : public QObject {
+  Q_OBJECT
+
+ public:
+  CQToolStripReplay(const CQToolStripRecording &recording);
+
+  //! get/set wait for recorded event times (instead of replaying as fast as possible)
+  bool isRealTime() const { return realTime_; }
+  void setRealTime(bool b) { realTime_ = b; }
+
+  //! replay all events and print time of each layout pass
+  void exec();
+
+ private slots:
+  void layoutAppliedSlot(double ms);
+
+ private:
+  void processEvents();
+
+ private:
+  typedef std::vector<double> Times;
+
+  const CQToolStripRecording &recording_;
+  QWidget                    *window_;
+  CQToolStrip                *strip_;
+  bool                        realTime_;
+  Times                       passes_;
+};
@@ -0,0 +1,28 @@
+TEMPLATE = app
+
+TARGET = CQToolStripReplay
+
+DEPENDPATH += .
+
+QT += widgets concurrent
+
+#CONFIG += debug
+
+# Input
+SOURCES += \
+CQToolStripReplay.cpp \
+
+HEADERS += \
+CQToolStripReplay.h \
+
+DESTDIR     = .
+OBJECTS_DIR = .
+
+INCLUDEPATH += \
+../include \
+../../CQToolStrip/include \
+.
+
+unix:LIBS += \
+-L../lib \
+-lCQToolStrip
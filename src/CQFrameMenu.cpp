@@ -3,21 +3,38 @@
 #include <QScrollBar>
 #include <QVBoxLayout>
 #include <QMouseEvent>
+#include <QGuiApplication>
+#include <QScreen>
 #include <iostream>
 
+// unused scroll areas (shared by all menus, only one menu open at a time)
+static std::vector<CQFrameMenuScrollArea *> scrollAreaPool;
+static int                                  numScrollAreas = 0;
+
 CQFrameMenu::
 CQFrameMenu(bool scrollable) :
- QMenu(0), scrollable_(scrollable), resizeSides_(ALL_SIDES), popupWidget_(0),
- sizeHintIsMax_(false), frame_(0), scrollArea_(0), sideInited_(false), pressed_(false)
+ QMenu(0), scrollable_(scrollable), popupHost_(false), popup_(0), resizeSides_(ALL_SIDES),
+ popupWidget_(0), widget_(0), sizeHintIsMax_(false), frame_(0), action_(0), scrollArea_(0),
+ sideInited_(false), pressed_(false), phaseTiming_(false)
 {
-  action_ = new CQFrameMenuAction(this);
-
-  QMenu::addAction(action_);
+  // frame, action and scroll area are created (or taken from pool) when first shown
 
   connect(this, SIGNAL(aboutToShow()), this, SLOT(aboutToShowSlot()));
   connect(this, SIGNAL(aboutToHide()), this, SLOT(aboutToHideSlot()));
 }
 
+CQFrameMenu::
+~CQFrameMenu()
+{
+  if (popup_)
+    popup_->setFrame(0);
+
+  releaseFrame();
+
+  delete frame_;
+  delete popup_;
+}
+
 void
 CQFrameMenu::
 setScrollable(bool scrollable)
@@ -25,6 +42,57 @@ setScrollable(bool scrollable)
   scrollable_ = scrollable;
 }
 
+void
+CQFrameMenu::
+setPopupHost(bool b)
+{
+  if (b == popupHost_)
+    return;
+
+  popupHost_ = b;
+
+  // frame added to popup window (and then stays parented to it) on first show
+  if (popupHost_) {
+    if (! popup_)
+      popup_ = new CQFrameMenuPopup(this);
+  }
+  else {
+    popup_->setFrame(0);
+
+    releaseFrame();
+  }
+}
+
+bool
+CQFrameMenu::
+isOpen() const
+{
+  return popupWindow()->isVisible();
+}
+
+QWidget *
+CQFrameMenu::
+popupWindow() const
+{
+  if (popupHost_)
+    return popup_;
+
+  return const_cast<CQFrameMenu *>(this);
+}
+
+QPoint
+CQFrameMenu::
+frameOffset() const
+{
+  // no action margins in popup host
+  if (popupHost_ || ! action_)
+    return QPoint(0, 0);
+
+  QRect ar = actionGeometry(action_);
+
+  return QPoint(std::max(ar.x(), 0), std::max(ar.y(), 0));
+}
+
 void
 CQFrameMenu::
 setResizeSides(uint sides)
@@ -44,15 +112,46 @@ CQFrameMenu::
 initFrame()
 {
   if (scrollable_) {
-    if (! scrollArea_)
-      scrollArea_ = new CQFrameMenuScrollArea(this);
+    if (! scrollArea_) {
+      scrollArea_ = CQFrameMenuScrollArea::acquire(this);
+
+      // restore size and contents from last show
+      scrollArea_->setSavedSize(savedSize_);
+
+      if (widget_)
+        scrollArea_->setWidget(widget_);
+
+      if (contentsSize_.isValid())
+        scrollArea_->setContentsSize(contentsSize_);
+    }
   }
   else {
-    if (! frame_)
+    if (! frame_) {
       frame_ = new CQFrameMenuFrame(this);
+
+      if (widget_)
+        frame_->setWidget(widget_);
+    }
   }
 }
 
+// return scroll area to pool
+void
+CQFrameMenu::
+releaseFrame()
+{
+  if (! scrollArea_)
+    return;
+
+  savedSize_ = scrollArea_->savedSize();
+
+  scrollArea_->setWidget(0);
+
+  CQFrameMenuScrollArea::release(scrollArea_);
+
+  scrollArea_ = 0;
+}
+
 QFrame *
 CQFrameMenu::
 frame() const
@@ -69,11 +168,13 @@ void
 CQFrameMenu::
 setWidget(QWidget *w)
 {
-  initFrame();
+  widget_ = w;
 
-  if (scrollable_)
+  contentsSize_ = QSize();
+
+  if      (scrollArea_)
     scrollArea_->setWidget(w);
-  else
+  else if (frame_)
     frame_->setWidget(w);
 }
 
@@ -81,41 +182,148 @@ void
 CQFrameMenu::
 popup(const QPoint &gpos)
 {
-  QMenu::popup(gpos);
+  if (! popupHost_) {
+    QMenu::popup(gpos);
+    return;
+  }
+
+  if (popup_->isVisible())
+    return;
+
+  // size before show so window can be kept on screen
+  aboutToShowSlot();
+
+  QScreen *screen = QGuiApplication::screenAt(gpos);
+
+  if (! screen)
+    screen = QGuiApplication::primaryScreen();
+
+  QRect sr = screen->availableGeometry();
+
+  int x = std::max(std::min(gpos.x(), sr.right () - popup_->width () + 1), sr.left());
+  int y = std::max(std::min(gpos.y(), sr.bottom() - popup_->height() + 1), sr.top ());
+
+  popup_->move(x, y);
+
+  popup_->show();
+}
+
+void
+CQFrameMenu::
+hidePopup()
+{
+  popupWindow()->hide();
+}
+
+void
+CQFrameMenu::
+paintEvent(QPaintEvent *e)
+{
+  phasePaint();
+
+  QMenu::paintEvent(e);
+
+  popupPaintEvent();
 }
 
 void
 CQFrameMenu::
 aboutToShowSlot()
 {
+  QElapsedTimer timer;
+
+  if (phaseTiming_)
+    timer.start();
+
   sideInited_ = false;
 
+  initFrame();
+
+  if (popupHost_) {
+    popup_->setFrame(frame());
+  }
+  else {
+    // action only added while shown (frame may be shared with other menus)
+    if (! action_)
+      action_ = new CQFrameMenuAction(this);
+
+    QMenu::addAction(action_);
+  }
+
+  qint64 t1 = (phaseTiming_ ? timer.nsecsElapsed() : 0);
+
   emit openMenu();
 
+  qint64 t2 = (phaseTiming_ ? timer.nsecsElapsed() : 0);
+
   if (scrollable_) {
     QSize s = scrollArea_->initSize();
 
     initSize(s);
   }
+
+  if (phaseTiming_) {
+    qint64 t3 = timer.nsecsElapsed();
+
+    phaseTimes_.aboutToShow = t3/1e6;
+    phaseTimes_.open        = (t2 - t1)/1e6;
+    phaseTimes_.size        = (t3 - t2)/1e6;
+    phaseTimes_.polish      = 0.0;
+
+    // polish time is until first paint
+    phaseTimer_.start();
+  }
 }
 
 void
 CQFrameMenu::
 aboutToHideSlot()
 {
+  QElapsedTimer timer;
+
+  if (phaseTiming_)
+    timer.start();
+
   emit closeMenu();
+
+  if (phaseTiming_)
+    phaseTimes_.close = timer.nsecsElapsed()/1e6;
+
+  // popup host keeps its frame
+  if (! popupHost_) {
+    QMenu::removeAction(action_);
+
+    releaseFrame();
+  }
+}
+
+void
+CQFrameMenu::
+phasePaint()
+{
+  if (! phaseTimer_.isValid())
+    return;
+
+  phaseTimes_.polish = phaseTimer_.nsecsElapsed()/1e6;
+
+  phaseTimer_.invalidate();
 }
 
 void
 CQFrameMenu::
 adjustMenuRect(int dxl, int dyb, int dxr, int dyt)
 {
-  QRect ar = actionGeometry(action_);
+  // requested deltas (before limit to scroll area size)
+  emit menuRectAdjusted(dxl, dyb, dxr, dyt);
 
-  int dx = std::max(ar.x(), 0);
-  int dy = std::max(ar.y(), 0);
+  QPoint fo = frameOffset();
 
-  QRect r = geometry();
+  int dx = fo.x();
+  int dy = fo.y();
+
+  QWidget *w = popupWindow();
+
+  QRect r = w->geometry();
 
   QRect dr = r.adjusted(dxl, dyb, dxr, dyt);
 //std::cerr << "adjustMenuRect " << dr.width() << " " << dr.height() << std::endl;
@@ -145,7 +353,7 @@ adjustMenuRect(int dxl, int dyb, int dxr, int dyt)
     dr = r.adjusted(dxl, dyb, dxr, dyt);
   }
 
-  move(dr.x(), dr.y());
+  w->move(dr.x(), dr.y());
 
   int fw = dr.width () - 2*dx;
   int fh = dr.height() - 2*dy;
@@ -163,7 +371,7 @@ adjustMenuRect(int dxl, int dyb, int dxr, int dyt)
   int mh = fh + 2*dy;
 
   //resize(mw, mh);
-  setFixedSize(mw, mh);
+  w->setFixedSize(mw, mh);
 }
 
 void
@@ -171,10 +379,10 @@ CQFrameMenu::
 initSize(const QSize &s)
 {
 //std::cerr << "initSize " << s.width() << " " << s.height() << std::endl;
-  QRect ar = actionGeometry(action_);
+  QPoint fo = frameOffset();
 
-  int dx = std::max(ar.x(), 0);
-  int dy = std::max(ar.y(), 0);
+  int dx = fo.x();
+  int dy = fo.y();
 //std::cerr << "dx/dy " << dx << " " << dy << std::endl;
 
   int fw = s.width ();
@@ -193,7 +401,45 @@ initSize(const QSize &s)
   int mh = fh + 2*dy;
 
   //resize(mw, mh);
-  setFixedSize(mw, mh);
+  popupWindow()->setFixedSize(mw, mh);
+}
+
+void
+CQFrameMenu::
+updateContents()
+{
+  if (! isOpen())
+    return;
+
+  contentsSize_ = QSize();
+
+  if (scrollable_) {
+    scrollArea_->invalidateContentsSize();
+
+    scrollArea_->updateSize(scrollArea_->width(), scrollArea_->height());
+  }
+}
+
+void
+CQFrameMenu::
+prewarm(const QSize &contentsSize)
+{
+  ensurePolished();
+
+  // scroll area is shared so only make sure pool has one (taken from pool on show)
+  if (scrollable_)
+    CQFrameMenuScrollArea::reserve();
+  else
+    initFrame();
+
+  if (! popupHost_ && ! action_)
+    action_ = new CQFrameMenuAction(this);
+
+  // used when scroll area is taken from pool
+  contentsSize_ = contentsSize;
+
+  if (scrollArea_)
+    scrollArea_->setContentsSize(contentsSize_);
 }
 
 void
@@ -247,9 +493,11 @@ processFrameEvent(QFrame *frame, QEvent *e)
               adjustMenuRect(0, 0, 0, dy);
           }
           else {
-            QRect r = geometry();
+            QWidget *w = popupWindow();
 
-            move(r.x() + dx, r.y() + dy);
+            QRect r = w->geometry();
+
+            w->move(r.x() + dx, r.y() + dy);
           }
         }
 
@@ -268,7 +516,7 @@ processFrameEvent(QFrame *frame, QEvent *e)
       break;
     }
     case QEvent::Leave: {
-      setCursor(Qt::ArrowCursor);
+      popupWindow()->setCursor(Qt::ArrowCursor);
 
       break;
     }
@@ -286,24 +534,24 @@ updateCursor(QFrame *frame, const QPoint &p)
   if (insideBorder(frame, p, side)) {
     switch (side) {
       case TOP_LEFT_SIDE: case BOTTOM_RIGHT_SIDE:
-        setCursor(Qt::SizeFDiagCursor);
+        popupWindow()->setCursor(Qt::SizeFDiagCursor);
         break;
       case BOTTOM_LEFT_SIDE: case TOP_RIGHT_SIDE:
-        setCursor(Qt::SizeBDiagCursor);
+        popupWindow()->setCursor(Qt::SizeBDiagCursor);
         break;
       case TOP_SIDE: case BOTTOM_SIDE:
-        setCursor(Qt::SizeVerCursor);
+        popupWindow()->setCursor(Qt::SizeVerCursor);
         break;
       case LEFT_SIDE: case RIGHT_SIDE:
-        setCursor(Qt::SizeHorCursor);
+        popupWindow()->setCursor(Qt::SizeHorCursor);
         break;
       default:
-        setCursor(Qt::ArrowCursor);
+        popupWindow()->setCursor(Qt::ArrowCursor);
         break;
     }
   }
   else
-    setCursor(Qt::ArrowCursor);
+    popupWindow()->setCursor(Qt::ArrowCursor);
 }
 
 bool
@@ -371,7 +619,7 @@ CQFrameMenuFrame(CQFrameMenu *menu) :
   setLineWidth(3);
 
   layout_ = new QVBoxLayout(this);
-  layout_->setMargin(0); layout_->setSpacing(0);
+  layout_->setContentsMargins(0, 0, 0, 0); layout_->setSpacing(0);
 }
 
 void
@@ -410,6 +658,54 @@ eventFilter(QObject *, QEvent *e)
 
 //------
 
+CQFrameMenuPopup::
+CQFrameMenuPopup(CQFrameMenu *menu) :
+ QWidget(0, Qt::Popup), menu_(menu), frame_(0)
+{
+  setObjectName("popup");
+
+  // press outside to close doesn't reopen from same press
+  setAttribute(Qt::WA_NoMouseReplay);
+}
+
+void
+CQFrameMenuPopup::
+setFrame(QFrame *frame)
+{
+  if (frame == frame_)
+    return;
+
+  if (frame_)
+    frame_->setParent(0);
+
+  frame_ = frame;
+
+  if (frame_) {
+    frame_->setParent(this);
+
+    frame_->move(0, 0);
+    frame_->show();
+  }
+}
+
+void
+CQFrameMenuPopup::
+hideEvent(QHideEvent *)
+{
+  menu_->aboutToHideSlot();
+}
+
+void
+CQFrameMenuPopup::
+paintEvent(QPaintEvent *)
+{
+  menu_->phasePaint();
+
+  menu_->popupPaintEvent();
+}
+
+//------
+
 CQFrameMenuAction::
 CQFrameMenuAction(CQFrameMenu *menu) :
  QWidgetAction(menu), menu_(menu)
@@ -431,13 +727,12 @@ createWidget(QWidget *parent)
 
 void
 CQFrameMenuAction::
-deleteWidget(QWidget *)
+deleteWidget(QWidget *widget)
 {
-  QFrame *frame = menu_->frame();
+  // frame may already be back in pool so use widget
+  widget->setParent(0);
 
-  frame->setParent(0);
-
-  frame->hide();
+  widget->hide();
 }
 
 //------
@@ -466,6 +761,80 @@ CQFrameMenuScrollArea(CQFrameMenu *menu) :
   contents_->setCursor(Qt::ArrowCursor);
 
   resizeEvent(0);
+
+  ++numScrollAreas;
+}
+
+CQFrameMenuScrollArea *
+CQFrameMenuScrollArea::
+acquire(CQFrameMenu *menu)
+{
+  CQFrameMenuScrollArea *area = 0;
+
+  if (! scrollAreaPool.empty()) {
+    area = scrollAreaPool.back();
+
+    scrollAreaPool.pop_back();
+
+    area->menu_ = menu;
+  }
+  else
+    area = new CQFrameMenuScrollArea(menu);
+
+  return area;
+}
+
+void
+CQFrameMenuScrollArea::
+reserve()
+{
+  if (! scrollAreaPool.empty())
+    return;
+
+  auto *area = new CQFrameMenuScrollArea(0);
+
+  area->ensurePolished();
+
+  scrollAreaPool.push_back(area);
+}
+
+void
+CQFrameMenuScrollArea::
+release(CQFrameMenuScrollArea *area)
+{
+  area->setParent(0);
+  area->hide();
+
+  area->menu_ = 0;
+
+  area->hbar_->setValue(0);
+  area->vbar_->setValue(0);
+
+  area->invalidateContentsSize();
+
+  scrollAreaPool.push_back(area);
+}
+
+int
+CQFrameMenuScrollArea::
+numCreated()
+{
+  return numScrollAreas;
+}
+
+int
+CQFrameMenuScrollArea::
+poolSize()
+{
+  return int(scrollAreaPool.size());
+}
+
+void
+CQFrameMenuScrollArea::
+setSavedSize(const QSize &s)
+{
+  cw_ = s.width ();
+  ch_ = s.height();
 }
 
 void
@@ -477,17 +846,44 @@ setWidget(QWidget *w)
 
   w_ = w;
 
-  w_->setParent(contents_);
+  if (w_)
+    w_->setParent(contents_);
+
+  invalidateContentsSize();
 
   resizeEvent(0);
 }
 
+QSize
+CQFrameMenuScrollArea::
+contentsSize() const
+{
+  if (contentsSize_.isValid())
+    return contentsSize_;
+
+  return (w_ ? CQWidgetUtil::SmartMinSize(w_) : QSize(0, 0));
+}
+
+void
+CQFrameMenuScrollArea::
+setContentsSize(const QSize &s)
+{
+  contentsSize_ = s;
+}
+
+void
+CQFrameMenuScrollArea::
+invalidateContentsSize()
+{
+  contentsSize_ = QSize();
+}
+
 QSize
 CQFrameMenuScrollArea::
 initSize()
 {
   if (cw_ <= 0 || ch_ <= 0) {
-    QSize s = CQWidgetUtil::SmartMinSize(w_);
+    QSize s = contentsSize();
 //std::cerr << "minSize " << s.width() << " " << s.height() << std::endl;
 
     int fw = frameWidth();
@@ -572,7 +968,7 @@ updateSize(int w, int h)
   int iw = w - 2*fw;
   int ih = h - 2*fw;
 
-  QSize s = (w_ ? CQWidgetUtil::SmartMinSize(w_) : minimumSizeHint());
+  QSize s = (w_ ? contentsSize() : minimumSizeHint());
 
   //---
 
@@ -642,7 +1038,7 @@ minimumSizeHint() const
     QSize s(0, 0);
 
     if (w_)
-      s = CQWidgetUtil::SmartMinSize(w_);
+      s = contentsSize();
 
     int sw = vbar_->sizeHint().width ();
     int sh = hbar_->sizeHint().height();
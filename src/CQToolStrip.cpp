@@ -1,17 +1,41 @@
 #include <CQToolStrip.h>
-#include <CQWidgetUtil.h>
+#include <CQToolStripLayout.h>
+#include <CQToolStripMetricCache.h>
+#include <CQToolStripLayoutSolver.h>
+#include <CQToolStripColumnModel.h>
+#include <CQToolStripSpec.h>
+#include <CQToolStripMemory.h>
 #include <QLabel>
 #include <QLineEdit>
 #include <QStyle>
 #include <QStylePainter>
 #include <QStyleOption>
 #include <QMouseEvent>
+#include <QWheelEvent>
 #include <QHBoxLayout>
+#include <QDataStream>
+#include <QFutureWatcher>
+#include <QElapsedTimer>
+#include <QTimer>
+#include <QtConcurrentRun>
 #include <iostream>
+#include <algorithm>
+#include <iterator>
+#include <map>
+
+// saved state header
+static const quint32 stateMagic   = 0x43515453; // 'CQTS'
+static const quint8  stateVersion = 1;
 
 CQToolStrip::
 CQToolStrip(QWidget *parent) :
- QWidget(parent), orientation_(Qt::Horizontal), menu_(0), splitterPos_(0), labelHeight_(0)
+ QWidget(parent), orientation_(Qt::Horizontal), menu_(0), splitterPos_(0), labelHeight_(0),
+ clip_(false), layoutDirty_(true), segmentsValid_(false), asyncLayout_(false),
+ asyncThreshold_(1000), layoutGeneration_(0), layoutWatcher_(0), layoutBudget_(0),
+ layoutTimer_(0), pendingResult_(0), pendingPos_(0), pendingVisible_(0), prewarmTimer_(0),
+ popupLatency_(-1), overflowPolicy_(OverflowMenu), scrollPos_(0), scrollRange_(0),
+ scrollBackButton_(0), scrollForwardButton_(0), wrapBreadth_(0), columnModel_(0),
+ relayoutTimer_(0), sizeHintTimer_(0), layoutPassDepth_(0)
 {
   menuButton_ = new CQToolStripMenuButton(this);
 
@@ -20,6 +44,28 @@ CQToolStrip(QWidget *parent) :
   menuButton_->setMenu(menu_);
 }
 
+void
+CQToolStrip::
+setOrientation(Qt::Orientation orientation)
+{
+  if (orientation == orientation_)
+    return;
+
+  orientation_ = orientation;
+
+  menuButton_->updateIcon();
+
+  // area display widths are lengths along the old orientation
+  for (auto *area : areas_)
+    area->setDisplayWidth(-1);
+
+  layoutDirty_ = true;
+
+  invalidateSizeHints();
+
+  updateLayout(true);
+}
+
 CQToolStripArea *
 CQToolStrip::
 addWidget(QWidget *w)
@@ -28,7 +74,8 @@ addWidget(QWidget *w)
 
   area->setWidget(w);
 
-  if (qobject_cast<QLineEdit *>(w))
+  // line edits and nested strips can be shrunk
+  if (qobject_cast<QLineEdit *>(w) || qobject_cast<CQToolStrip *>(w))
     area->setResizable(true);
 
   addArea(area);
@@ -45,7 +92,8 @@ addWidget(const QString &label, QWidget *w)
   area->setWidget(w);
   area->setLabel (label);
 
-  if (qobject_cast<QLineEdit *>(w))
+  // line edits and nested strips can be shrunk
+  if (qobject_cast<QLineEdit *>(w) || qobject_cast<CQToolStrip *>(w))
     area->setResizable(true);
 
   addArea(area);
@@ -57,482 +105,1792 @@ void
 CQToolStrip::
 addArea(CQToolStripArea *area)
 {
-  areas_.push_back(area);
-
-  updateLayout(true);
+  insertArea(numAreas(), area);
 }
 
 void
 CQToolStrip::
-showEvent(QShowEvent *)
+addAreas(const std::vector<CQToolStripArea *> &areas)
 {
-  updateLayout(true);
-}
+  int ind = numAreas();
 
-void
-CQToolStrip::
-resizeEvent(QResizeEvent *)
-{
-  //expandToFit();
+  dropProgressiveLayout();
 
-  updateLayout(true);
+  // larger label needs full layout
+  bool full = false;
+
+  for (auto *area : areas) {
+    if (area->parentWidget() != this)
+      area->setParent(this);
+
+    areas_.push_back(area);
+
+    updateAreaGroup(numAreas() - 1);
+
+    if (area->labelMinHeight() > labelHeight_)
+      full = true;
+  }
+
+  if (ind >= numAreas())
+    return;
+
+  invalidateSizeHints();
+
+  updateLayoutFrom(ind, full);
 }
 
 void
 CQToolStrip::
-updateLayout(bool updateSplitters)
+insertArea(int ind, CQToolStripArea *area)
 {
-  if (updateSplitters) {
-    menuButton_->hide();
-
-    auto n = areas_.size();
+  int n = numAreas();
 
-    for (uint i = 0; i < n; ++i) {
-      auto *area = areas_[i];
-
-      area->setVisible(true);
-    }
+  ind = std::min(std::max(ind, 0), n);
 
-    updateLabelHeight();
+  dropProgressiveLayout();
 
-    bool clip = reduceSize();
+  if (area->parentWidget() != this)
+    area->setParent(this);
 
-    updateVisible();
+  areas_.insert(areas_.begin() + ind, area);
 
-    hideSplitters();
+  updateAreaGroup(ind);
 
-    // place areas
-    int x = 2;
+  invalidateSizeHints();
 
-    for (uint i = 0; i < n; ++i) {
-      auto *area = areas_[i];
+  // larger label needs full layout
+  bool full = (area->labelMinHeight() > labelHeight_);
 
-      //if (! area->isVisible()) continue;
+  updateLayoutFrom(ind, full);
+}
 
-      area->updateLayout();
+CQToolStripArea *
+CQToolStrip::
+removeArea(int ind)
+{
+  if (ind < 0 || ind >= numAreas())
+    return 0;
 
-      int w = area->displayWidth();
+  auto *area = areas_[uint(ind)];
 
-      area->move  (x, 0);
-      area->resize(w, height());
+  dropProgressiveLayout();
 
-      x += w + 2;
+  // remove from open menu (overflow or group menu)
+  if (area->isClipped())
+    menu_->removeArea(area);
+  else if (area->group_ && area->group_->button_) {
+    auto *groupMenu = qobject_cast<CQToolStripMenu *>(area->group_->button_->menu());
 
-      if (area->isResizable() && i < n - 1) {
-        CQToolStripSplitter *splitter = getSplitter();
+    if (groupMenu)
+      groupMenu->removeArea(area);
+  }
 
-        splitter->init(int(i), Qt::Vertical);
+  areas_.erase(areas_.begin() + ind);
 
-        splitter->move  (x - 1, 0);
-        splitter->resize(4, height());
+  // drop any pending relayout (area may be deleted)
+  relayoutAreas_.erase(std::remove(relayoutAreas_.begin(), relayoutAreas_.end(), area),
+                       relayoutAreas_.end());
 
-        splitter->show();
+  area->group_ = 0;
+  area->index_ = -1;
 
-        connect(splitter, SIGNAL(splitterMoved(int, int)), this, SLOT(splitterMoved(int, int)));
+  area->hide();
+  area->setParent(0);
 
-        x += 4; // splitter width
-      }
-    }
+  invalidateSizeHints();
 
-    menuButton_->setVisible(clip);
+  // removing largest label may reduce label height
+  int lh = area->labelMinHeight();
 
-    if (clip) {
-      //menuButton_->resize(8, height());
+  bool full = (lh > 0 && lh >= labelHeight_);
 
-      menuButton_->move( width () - menuButton_->width (),
-                        (height() - menuButton_->height())/2);
+  updateLayoutFrom(ind, full);
 
-      menuButton_->raise();
-    }
-  }
-  else {
-    int spliiterNum = 0;
+  return area;
+}
 
-    // place areas
-    int x = 2;
+bool
+CQToolStrip::
+removeArea(CQToolStripArea *area)
+{
+  int ind = areaIndex(area);
 
-    auto n = areas_.size();
+  if (ind < 0)
+    return false;
 
-    for (uint i = 0; i < n; ++i) {
-      auto *area = areas_[i];
+  removeArea(ind);
 
-      //if (! area->isVisible()) continue;
+  return true;
+}
 
-      int w = area->displayWidth();
+void
+CQToolStrip::
+moveArea(int from, int to)
+{
+  int n = numAreas();
 
-      area->move  (x, 0);
-      area->resize(w, height());
+  if (from < 0 || from >= n || to < 0 || to >= n || from == to)
+    return;
 
-      x += w + 2;
+  auto *area = areas_[uint(from)];
 
-      if (area->isResizable() && i < n - 1) {
-        auto *splitter = splitters_[uint(spliiterNum++)];
+  dropProgressiveLayout();
 
-        disconnect(splitter, SIGNAL(splitterMoved(int, int)), this, SLOT(splitterMoved(int, int)));
+  areas_.erase (areas_.begin() + from);
+  areas_.insert(areas_.begin() + to, area);
 
-        splitter->move(x - 1, 0);
+  updateAreaGroup(to);
 
-        connect(splitter, SIGNAL(splitterMoved(int, int)), this, SLOT(splitterMoved(int, int)));
+  invalidateSegments();
 
-        x += 4; // splitter width
-      }
-    }
-  }
+  updateLayoutFrom(std::min(from, to), false);
 }
 
+// keep groups contiguous after area is added/moved to index
 void
 CQToolStrip::
-updateLabelHeight()
+updateAreaGroup(int ind)
 {
-  auto n = areas_.size();
+  auto *area = areas_[uint(ind)];
 
-  // determine label height
-  labelHeight_ = 0;
+  int n = numAreas();
 
-  for (uint i = 0; i < n; ++i) {
-    CQToolStripArea *area = areas_[i];
+  auto *prevGroup = (ind > 0     ? areas_[uint(ind - 1)]->group_ : 0);
+  auto *nextGroup = (ind < n - 1 ? areas_[uint(ind + 1)]->group_ : 0);
+
+  // area between two areas of same group joins group
+  if (prevGroup && prevGroup == nextGroup) {
+    area->group_ = prevGroup;
+    return;
+  }
 
-    //if (! area->isVisible()) continue;
+  auto *group = area->group_;
 
-    int labelHeight = area->labelMinHeight();
+  if (! group || group == prevGroup || group == nextGroup)
+    return;
 
-    labelHeight_ = std::max(labelHeight_, labelHeight);
+  // area no longer next to rest of its group
+  for (int i = 0; i < n; ++i) {
+    if (i != ind && areas_[uint(i)]->group_ == group) {
+      area->group_ = 0;
+      break;
+    }
   }
-//std::cerr << "labelHeight " << labelHeight_ << std::endl;
 }
 
 int
 CQToolStrip::
-contentsWidth() const
+areaIndex(CQToolStripArea *area) const
 {
-  int w = 2;
+  auto p = std::find(areas_.begin(), areas_.end(), area);
 
-  auto n = areas_.size();
+  if (p == areas_.end())
+    return -1;
 
-  for (uint i = 0; i < n; ++i) {
-    CQToolStripArea *area = areas_[i];
+  return int(p - areas_.begin());
+}
+
+CQToolStripGroup *
+CQToolStrip::
+addGroup(const QString &name, int start, int end)
+{
+  if (name.isEmpty() || getGroup(name))
+    return 0;
+
+  int n = numAreas();
 
-    int w1 = area->displayWidth();
+  start = std::max(start, 0);
+  end   = std::min(end, n - 1);
 
-    w += w1 + 2;
+  if (start > end)
+    return 0;
 
-    if (area->isResizable() && i < n - 1)
-      w += 4; // splitter width
+  // areas can only be in one group
+  for (int i = start; i <= end; ++i) {
+    if (areas_[uint(i)]->group_)
+      return 0;
   }
 
-  return w;
-}
+  auto *group = new CQToolStripGroup(this, name);
 
-std::vector<int>
-CQToolStrip::
-getResizeInds() const
-{
-  std::vector<int> inds;
+  groups_.push_back(group);
 
-  auto n = areas_.size();
+  for (int i = start; i <= end; ++i)
+    areas_[uint(i)]->group_ = group;
 
-  for (uint i = 0; i < n; ++i) {
-    CQToolStripArea *area = areas_[i];
+  invalidateSizeHints();
 
-    if (area->isResizable() && i < n - 1)
-      inds.push_back(int(i));
-  }
+  updateLayout(true);
 
-  return inds;
+  return group;
 }
 
 bool
 CQToolStrip::
-reduceSize()
+removeGroup(CQToolStripGroup *group)
 {
-  int cw = contentsWidth();
+  auto p = std::find(groups_.begin(), groups_.end(), group);
 
-  int d = cw - width();
+  if (p == groups_.end())
+    return false;
 
-  // shrink resizable indexes as mush as possible if too small
-  std::vector<int> inds = getResizeInds();
+  groups_.erase(p);
 
-  while (d > 0 && ! inds.empty()) {
-    int ind = inds.back();
-
-    inds.pop_back();
+  for (auto *area : areas_) {
+    if (area->group_ == group)
+      area->group_ = 0;
+  }
 
-    auto *area = areas_[uint(ind)];
+  // button menu is not owned by button
+  if (group->button_) {
+    delete group->button_->menu();
+    delete group->button_;
+  }
 
-    int curW = area->displayWidth();
-    int minW = area->minimumSizeHint().width();
+  delete group;
 
-    if (curW > minW) {
-      int newW = std::max(curW - d, minW);
+  invalidateSizeHints();
 
-      d -= curW - newW;
+  updateLayout(true);
 
-      if (newW != curW)
-        area->setDisplayWidth(newW);
-    }
-  }
+  return true;
+}
 
-  return (d > 0);
+bool
+CQToolStrip::
+removeGroup(const QString &name)
+{
+  return removeGroup(getGroup(name));
 }
 
+// index range of group areas (-1 if none)
 void
 CQToolStrip::
-updateVisible()
+groupRange(const CQToolStripGroup *group, int &start, int &end) const
 {
-  bool visible = true;
-  int  visInd  = -1;
-
-  int x = 2;
-
-  auto n = areas_.size();
-
-  for (uint i = 0; i < n; ++i) {
-    auto *area = areas_[i];
-
-    int w = area->displayWidth();
+  start = -1;
+  end   = -1;
 
-    if (visible) {
-      if (x + w + 2 > width()) {
-        visible = false;
-        visInd  = int(i);
-      }
-    }
+  int n = numAreas();
 
-    area->setClipped(! visible);
-    area->setVisible(visible);
+  for (int i = 0; i < n; ++i) {
+    if (areas_[uint(i)]->group_ != group) continue;
 
-    x += w + 2;
+    if (start < 0)
+      start = i;
 
-    if (area->isResizable() && i < n - 1)
-      x += 4;
+    end = i;
   }
+}
 
-  //---
+// check area can change group without splitting old or new group
+bool
+CQToolStrip::
+canSetAreaGroup(CQToolStripArea *area, CQToolStripGroup *group) const
+{
+  if (group && group->strip() != this)
+    return false;
 
-  visible = true;
+  int ind = areaIndex(area);
 
-  x = 2;
+  // group fixed up when area added
+  if (ind < 0)
+    return true;
 
-  int bw = menuButton_->width();
+  int start, end;
 
-  for (int i = 0; i < visInd; ++i) {
-    auto *area = areas_[uint(i)];
+  // area must be at end of old group
+  if (area->group_) {
+    groupRange(area->group_, start, end);
 
-    int w = area->displayWidth();
+    if (ind > start && ind < end)
+      return false;
+  }
 
-    if (visible) {
-      if (x + w + bw + 2 > width())
-        visible = false;
-    }
+  // area must be next to new group
+  if (group) {
+    groupRange(group, start, end);
 
-    area->setClipped(! visible);
-    area->setVisible(visible);
+    if (start >= 0 && (ind < start - 1 || ind > end + 1))
+      return false;
+  }
 
-    x += w + 2;
+  return true;
+}
 
-    if (area->isResizable() && i < int(n - 1))
-      x += 4;
+CQToolStripGroup *
+CQToolStrip::
+getGroup(const QString &name) const
+{
+  for (auto *group : groups_) {
+    if (group->name() == name)
+      return group;
   }
+
+  return 0;
 }
 
 void
 CQToolStrip::
-hideSplitters()
+setGroupCollapsed(const QString &name, bool collapsed)
 {
-  for (int i = 0; i < splitterPos_; ++i)
-    splitters_[uint(i)]->hide();
+  auto *group = getGroup(name);
 
-  splitterPos_ = 0;
+  if (group)
+    group->setCollapsed(collapsed);
 }
 
-CQToolStripSplitter *
+bool
 CQToolStrip::
-getSplitter()
+hasCollapsedGroup() const
 {
-  while (splitterPos_ >= int(splitters_.size()))
-    splitters_.push_back(new CQToolStripSplitter(this));
+  for (auto *group : groups_) {
+    if (group->isShownCollapsed())
+      return true;
+  }
 
-  auto *splitter = splitters_[uint(splitterPos_++)];
+  return false;
+}
 
-  return splitter;
+void
+CQToolStrip::
+showEvent(QShowEvent *)
+{
+  // layout is deferred while hidden so only relayout if something changed
+  if (! layoutDirty_ && size() == layoutSize_)
+    return;
+
+  updateLayout(true);
 }
 
 void
 CQToolStrip::
-splitterMoved(int ind, int d)
+resizeEvent(QResizeEvent *)
 {
-  int fitW = contentsWidth();
+  //expandToFit();
 
-  auto *area = areas_[uint(ind)];
+  if (! layoutDirty_ && size() == layoutSize_)
+    return;
 
-  int min_area_width = area->minimumSizeHint().width();
-  int max_area_width = width() - minimumSizeHint().width();
-//std::cerr << "area min width " << min_area_width << std::endl;
-//std::cerr << "area max width " << max_area_width << std::endl;
+  // shortest strip limits column widths so column model lays out all its strips
+  // (once) after solving widths
+  if (columnModel_) {
+    columnModel_->scheduleUpdate();
+    return;
+  }
 
-  int w = std::min(std::max(area->displayWidth() + d, min_area_width), max_area_width);
+  updateLayout(true);
+}
 
-  d = w - area->displayWidth();
-//std::cerr << "d " << d << std::endl;
+// times layout pass from start of outermost layout call (nested calls are part of it)
+struct CQToolStrip::LayoutPass {
+  LayoutPass(CQToolStrip *strip) :
+   strip_(strip) {
+    if (strip_->layoutPassDepth_++ == 0)
+      strip_->layoutPassTimer_.start();
+  }
 
-  if (d > 0) {
-    // calc width
-    int cw = contentsWidth() + d;
+ ~LayoutPass() {
+    --strip_->layoutPassDepth_;
+  }
 
-    int dw = cw - width();
+  CQToolStrip *strip_;
+};
 
-    if (dw > 0) {
-//std::cerr << "shrink others " << dw << std::endl;
-      auto n = areas_.size();
+// report time since pass start (next pass in same call starts now)
+void
+CQToolStrip::
+emitLayoutApplied()
+{
+  double ms = layoutPassTimer_.nsecsElapsed()/1e6;
 
-      for (int i = ind + 1; i < int(n - 1); ++i) {
-        auto *area1 = areas_[uint(i)];
+  layoutPassTimer_.start();
 
-        //if (! area1->isVisible()) continue;
+  emit layoutApplied(ms);
+}
 
-        if (! area1->isResizable()) continue;
+void
+CQToolStrip::
+updateLayout(bool updateSplitters)
+{
+  LayoutPass pass(this);
 
-        int w1    = area1->displayWidth();
-        int minW1 = area1->minimumSizeHint().width();
+  if (updateSplitters) {
+    // replaced by this layout (or by layout when shown)
+    cancelProgressiveLayout();
 
-        if (w1 > minW1) {
-          w1 -= dw;
+    // no point in laying out until shown (show does single layout at final size)
+    if (! isVisible()) {
+      layoutDirty_ = true;
+      return;
+    }
 
-          int newW1 = std::max(w1 - dw, minW1);
+    layoutDirty_ = false;
+    layoutSize_  = size();
 
-          dw -= w1 - newW1;
+    if (useAsyncLayout()) {
+      requestAsyncLayout();
+      return;
+    }
 
-          if (newW1 != w1)
-            area1->setDisplayWidth(newW1);
-        }
-      }
+    // sync layout replaces any pending solve
+    ++layoutGeneration_;
 
-      cw = width() + dw;
+    // same solve as async layout (wrapped layout is incremental so done by layout)
+    if (overflowPolicy_ != OverflowWrap) {
+      applyLayoutResult(CQToolStripLayoutSolver::solve(layoutInput()));
+      return;
     }
+  }
+
+  if (orientation_ == Qt::Horizontal)
+    CQToolStripHLayout(this).updateLayout();
+  else
+    CQToolStripVLayout(this).updateLayout();
 
-    //---
+  emitLayoutApplied();
 
-    int maxW = width() - contentsWidth() + area->displayWidth();
+  if (updateSplitters) {
+    schedulePrewarm();
 
-    if (w > maxW) w = maxW;
+    emit layoutSettled();
+  }
+}
 
-    area->setDisplayWidth(w);
+void
+CQToolStrip::
+setAsyncLayout(bool async)
+{
+  asyncLayout_ = async;
 
-    //---
+  // drop any pending solve
+  if (! asyncLayout_) {
+    ++layoutGeneration_;
 
-    expandToFit(ind, fitW);
+    layoutAreas_.clear();
   }
-  else {
-    int minW = area->minimumSizeHint().width();
+}
 
-    if (w < minW) w = minW;
+void
+CQToolStrip::
+setLayoutBudget(int ms)
+{
+  layoutBudget_ = ms;
 
-    area->setDisplayWidth(w);
+  if (layoutBudget_ <= 0)
+    finishProgressiveLayout();
+}
 
-    //---
+bool
+CQToolStrip::
+isLayoutPending() const
+{
+  return (pendingResult_ || ! layoutAreas_.empty());
+}
 
-    expandToFit(ind, fitW);
-  }
+bool
+CQToolStrip::
+useAsyncLayout() const
+{
+  // wrapped layout is always sync
+  return (asyncLayout_ && numAreas() >= asyncThreshold_ && overflowPolicy_ != OverflowWrap);
+}
+
+// snapshot area metrics for solver
+CQToolStripLayoutInput
+CQToolStrip::
+layoutInput()
+{
+  updateLabelHeight();
+
+  CQToolStripLayoutInput input;
 
-  updateLayout(false);
+  if (orientation_ == Qt::Horizontal)
+    input = CQToolStripHLayout(this).snapshot();
+  else
+    input = CQToolStripVLayout(this).snapshot();
+
+  input.restored = restoreClipInd(input.clipInd);
+
+  return input;
 }
 
+// snapshot area metrics and solve layout on worker thread
 void
 CQToolStrip::
-expandToFit(int stopInd, int fitW)
+requestAsyncLayout()
 {
-  if (fitW < 0)
-    fitW = contentsWidth();
-//std::cerr << "Expand to fit " << fitW << std::endl;
-
-  auto n = areas_.size();
+  CQToolStripLayoutInput input = layoutInput();
 
-  for (int i = int(n - 2); i >= 0; --i) {
-    if (i == stopInd) break;
+  input.generation = ++layoutGeneration_;
 
-    auto *area1 = areas_[uint(i)];
+  layoutAreas_ = areas_;
 
-    //if (! area1->isVisible()) continue;
+  if (! layoutWatcher_) {
+    layoutWatcher_ = new LayoutWatcher(this);
 
-    if (! area1->isResizable()) continue;
+    connect(layoutWatcher_, SIGNAL(finished()), this, SLOT(asyncLayoutSolved()));
+  }
 
-    int dw = fitW - contentsWidth();
+  // running solve (if any) finishes in background and its result is discarded
+  layoutWatcher_->setFuture(QtConcurrent::run([input]() {
+    return CQToolStripLayoutSolver::solve(input);
+  }));
+}
 
-    int w1 = area1->displayWidth() + dw;
+// apply result of worker thread solve (if still current)
+void
+CQToolStrip::
+asyncLayoutSolved()
+{
+  CQToolStripLayoutResult result = layoutWatcher_->result();
 
-    int minW1 = area1->minimumSizeHint().width();
+  if (result.generation != layoutGeneration_)
+    return;
 
-    if (w1 < minW1) w1 = minW1;
+  // areas changed by partial layout since snapshot
+  if (layoutAreas_ != areas_) {
+    layoutAreas_.clear();
 
-    area1->setDisplayWidth(w1);
+    updateLayout(true);
 
     return;
   }
+
+  layoutAreas_.clear();
+
+  applyLayoutResult(result);
 }
 
-QSize
+// apply solved layout (in one go or progressively)
+void
 CQToolStrip::
-sizeHint() const
+applyLayoutResult(const CQToolStripLayoutResult &result)
 {
-  int w = 2, h = 0;
+  LayoutPass pass(this);
 
-  auto n = areas_.size();
+  if (layoutBudget_ > 0) {
+    startProgressiveLayout(result);
+    return;
+  }
 
-  for (uint i = 0; i < n; ++i) {
-    CQToolStripArea *area = areas_[i];
+  // keep open menu in sync with new clipped areas
+  bool menuOpen = menu_->isOpen();
+
+  if (menuOpen)
+    menu_->clearActions();
+
+  if (orientation_ == Qt::Horizontal)
+    CQToolStripHLayout(this).applyResult(result);
+  else
+    CQToolStripVLayout(this).applyResult(result);
 
-    w += area->minimumSizeHint().width() + 2;
-    h  = std::max(h, area->sizeHint().height());
+  schedulePrewarm();
 
-    if (area->isResizable() && i < n - 1)
-      w += 4;
+  if (menuOpen) {
+    menu_->addActions();
+
+    menu_->updateContents();
   }
 
-//std::cerr << "CQToolStrip::sizeHint " << w << " " << h << std::endl;
-  return QSize(w, h);
+  emitLayoutApplied();
+
+  emit layoutSettled();
 }
 
-QSize
+// apply clipping now and area geometry over several event loop iterations
+void
 CQToolStrip::
-minimumSizeHint() const
+startProgressiveLayout(const CQToolStripLayoutResult &result)
 {
-  int h = 0;
+  cancelProgressiveLayout();
 
-  auto n = areas_.size();
+  pendingResult_ = new LayoutResult(result);
 
-  for (uint i = 0; i < n; ++i) {
-    CQToolStripArea *area = areas_[i];
+  // keep open menu in sync with new clipped areas
+  bool menuOpen = menu_->isOpen();
+
+  if (menuOpen)
+    menu_->clearActions();
+
+  if (orientation_ == Qt::Horizontal)
+    CQToolStripHLayout(this).applyState(result);
+  else
+    CQToolStripVLayout(this).applyState(result);
 
-    h = std::max(h, area->minimumSizeHint().height());
+  schedulePrewarm();
+
+  if (menuOpen) {
+    menu_->addActions();
+
+    menu_->updateContents();
   }
 
-  int w = 32;
+  // visible areas first then hidden (clipped/collapsed) ones
+  int n = numAreas();
 
-//std::cerr << "CQToolStrip::minimumSizeHint " << w << " " << h << std::endl;
-  return QSize(w, h);
-}
+  for (int i = 0; i < n; ++i) {
+    if (result.areas[uint(i)].visible)
+      pendingInds_.push_back(i);
+  }
 
-//-------
+  pendingVisible_ = int(pendingInds_.size());
 
-CQToolStripArea::
-CQToolStripArea(CQToolStrip *strip) :
- QWidget(strip), strip_(strip), w_(0), flags_(NoFlags),
- alignment_(Qt::AlignLeft | Qt::AlignBottom), label_(0), resizable_(false),
- displayWidth_(-1), clipped_(false)
-{
+  for (int i = 0; i < n; ++i) {
+    if (! result.areas[uint(i)].visible)
+      pendingInds_.push_back(i);
+  }
+
+  pendingPos_ = 0;
+
+  if (! layoutTimer_) {
+    layoutTimer_ = new QTimer(this);
+
+    layoutTimer_->setSingleShot(true);
+    layoutTimer_->setInterval(0);
+
+    connect(layoutTimer_, SIGNAL(timeout()), this, SLOT(progressiveLayoutStep()));
+  }
+
+  progressiveLayoutStep();
 }
 
+// apply areas until time budget used
 void
-CQToolStripArea::
+CQToolStrip::
+progressiveLayoutStep()
+{
+  LayoutPass pass(this);
+
+  if (! pendingResult_)
+    return;
+
+  QElapsedTimer timer;
+
+  timer.start();
+
+  int n = int(pendingInds_.size());
+
+  while (pendingPos_ < n) {
+    int ind = pendingInds_[uint(pendingPos_++)];
+
+    if (orientation_ == Qt::Horizontal)
+      CQToolStripHLayout(this).applyArea(*pendingResult_, uint(ind));
+    else
+      CQToolStripVLayout(this).applyArea(*pendingResult_, uint(ind));
+
+    // splitters and buttons placed once visible areas are placed
+    if (pendingPos_ == pendingVisible_) {
+      if (orientation_ == Qt::Horizontal)
+        CQToolStripHLayout(this).applyControls(*pendingResult_);
+      else
+        CQToolStripVLayout(this).applyControls(*pendingResult_);
+    }
+
+    if (layoutBudget_ > 0 && timer.elapsed() >= layoutBudget_)
+      break;
+  }
+
+  emitLayoutApplied();
+
+  if (pendingPos_ < n) {
+    layoutTimer_->start();
+    return;
+  }
+
+  if (pendingVisible_ == 0) {
+    if (orientation_ == Qt::Horizontal)
+      CQToolStripHLayout(this).applyControls(*pendingResult_);
+    else
+      CQToolStripVLayout(this).applyControls(*pendingResult_);
+  }
+
+  cancelProgressiveLayout();
+
+  emit layoutSettled();
+}
+
+// apply remaining areas now
+void
+CQToolStrip::
+finishProgressiveLayout()
+{
+  if (! pendingResult_)
+    return;
+
+  int budget = layoutBudget_;
+
+  layoutBudget_ = 0;
+
+  progressiveLayoutStep();
+
+  layoutBudget_ = budget;
+}
+
+// prepare overflow menu in idle time after clipped areas change
+void
+CQToolStrip::
+schedulePrewarm()
+{
+  menu_->invalidatePrewarm();
+
+  if (! clip_)
+    return;
+
+  if (! prewarmTimer_) {
+    prewarmTimer_ = new QTimer(this);
+
+    prewarmTimer_->setSingleShot(true);
+    prewarmTimer_->setInterval(0);
+
+    connect(prewarmTimer_, SIGNAL(timeout()), this, SLOT(prewarmMenu()));
+  }
+
+  prewarmTimer_->start();
+}
+
+void
+CQToolStrip::
+prewarmMenu()
+{
+  if (clip_ && ! menu_->isOpen())
+    menu_->prewarm();
+}
+
+bool
+CQToolStrip::
+isPopupHost() const
+{
+  return menu_->isPopupHost();
+}
+
+void
+CQToolStrip::
+setPopupHost(bool b)
+{
+  if (b == isPopupHost())
+    return;
+
+  menu_->setPopupHost(b);
+
+  // tool button can only show QMenu so popup host is shown on press
+  if (b) {
+    menuButton_->setMenu(0);
+
+    connect(menuButton_, SIGNAL(pressed()), this, SLOT(popupMenu()));
+  }
+  else {
+    disconnect(menuButton_, SIGNAL(pressed()), this, SLOT(popupMenu()));
+
+    menuButton_->setMenu(menu_);
+  }
+}
+
+// show popup host below (or right of) menu button
+void
+CQToolStrip::
+popupMenu()
+{
+  QPoint pos;
+
+  if (orientation_ == Qt::Horizontal)
+    pos = QPoint(0, menuButton_->height());
+  else
+    pos = QPoint(menuButton_->width(), 0);
+
+  menu_->popup(menuButton_->mapToGlobal(pos));
+}
+
+void
+CQToolStrip::
+setPopupLatency(double ms)
+{
+  popupLatency_ = ms;
+
+  emit popupLatencyMeasured(ms);
+}
+
+CQToolStrip::MemoryStats
+CQToolStrip::
+memoryStats() const
+{
+  using namespace CQToolStripMemory;
+
+  MemoryStats stats;
+
+  // areas, labels and splitters
+  stats.numAreas     = numAreas();
+  stats.numSplitters = int(splitters_.size());
+
+  stats.objectBytes = sizeof(*this) + vectorBytes(areas_) + vectorBytes(splitters_) +
+                      vectorBytes(groups_) + areas_.size()*sizeof(CQToolStripArea) +
+                      splitters_.size()*sizeof(CQToolStripSplitter);
+
+  for (const auto *area : areas_) {
+    if (area->label_) {
+      ++stats.numLabels;
+
+      stats.objectBytes += sizeof(QLabel);
+    }
+
+    stats.objectBytes += stringBytes(area->labelText_);
+  }
+
+  // menu button and scroll buttons
+  stats.numControls  = 1;
+  stats.objectBytes += sizeof(CQToolStripMenuButton);
+
+  if (scrollBackButton_) {
+    stats.numControls += 2;
+    stats.objectBytes += 2*sizeof(QToolButton);
+  }
+
+  // overflow menu and group menus (created with group button)
+  std::vector<CQToolStripMenu *> menus;
+
+  menus.push_back(menu_);
+
+  for (const auto *group : groups_) {
+    stats.objectBytes += sizeof(CQToolStripGroup) + stringBytes(group->name_);
+
+    if (! group->button_)
+      continue;
+
+    ++stats.numControls;
+
+    stats.objectBytes += sizeof(CQToolStripGroupButton);
+
+    auto *menu = qobject_cast<CQToolStripMenu *>(group->button_->menu());
+
+    if (menu)
+      menus.push_back(menu);
+  }
+
+  for (const auto *menu : menus) {
+    ++stats.numMenus;
+
+    stats.numMenuWidgets += 2; // contents and search
+
+    stats.objectBytes += sizeof(CQToolStripMenu) + sizeof(CQToolStripMenuContents) +
+                         sizeof(QLineEdit);
+
+    stats.cacheBytes += menu->memoryBytes();
+  }
+
+  //---
+
+  stats.layoutBytes = vectorBytes(activeInds_) + lengths_.memoryBytes() +
+                      geometry_.memoryBytes() +
+                      vectorBytes(layoutAreas_) + vectorBytes(pendingInds_) +
+                      vectorBytes(rows_) + vectorBytes(relayoutAreas_);
+
+  if (pendingResult_)
+    stats.layoutBytes += sizeof(LayoutResult) + vectorBytes(pendingResult_->areas) +
+                         vectorBytes(pendingResult_->splitters) +
+                         vectorBytes(pendingResult_->groups);
+
+  stats.cacheBytes += heightForWidth_.size()*(mapNodeBytes + sizeof(HeightForWidth::value_type));
+
+  return stats;
+}
+
+void
+CQToolStrip::
+dumpMemory(std::ostream &os) const
+{
+  MemoryStats stats = memoryStats();
+
+  os << "CQToolStrip '" << objectName().toStdString() << "' memory" << std::endl;
+
+  os << "  widgets " << stats.numWidgets() <<
+        " (areas "        << stats.numAreas       <<
+        ", labels "       << stats.numLabels      <<
+        ", splitters "    << stats.numSplitters   <<
+        ", controls "     << stats.numControls    <<
+        ", menus "        << stats.numMenus       <<
+        ", menu widgets " << stats.numMenuWidgets << ")" << std::endl;
+
+  os << "  objects " << stats.objectBytes << " bytes" << std::endl;
+  os << "  layout  " << stats.layoutBytes << " bytes" << std::endl;
+  os << "  caches  " << stats.cacheBytes  << " bytes" << std::endl;
+  os << "  total   " << stats.totalBytes() << " bytes" << std::endl;
+
+  // shared by all strips
+  auto *cache = CQToolStripMetricCache::instance();
+
+  os << "  shared: menu scroll areas " << CQFrameMenuScrollArea::numCreated() <<
+        " (" << CQFrameMenuScrollArea::poolSize() << " in pool), metric cache " <<
+        cache->size() << " entries " << cache->memoryBytes() << " bytes (file " <<
+        cache->fileSize() << " entries)" << std::endl;
+}
+
+void
+CQToolStrip::
+setOverflowPolicy(OverflowPolicy policy)
+{
+  if (policy == overflowPolicy_)
+    return;
+
+  overflowPolicy_ = policy;
+
+  if (overflowPolicy_ == OverflowScroll && ! scrollBackButton_) {
+    scrollBackButton_    = new QToolButton(this);
+    scrollForwardButton_ = new QToolButton(this);
+
+    scrollBackButton_   ->setObjectName("scrollBack");
+    scrollForwardButton_->setObjectName("scrollForward");
+
+    for (auto *button : {scrollBackButton_, scrollForwardButton_}) {
+      button->setAutoRaise  (true);
+      button->setAutoRepeat (true);
+      button->setFocusPolicy(Qt::NoFocus);
+      button->hide();
+    }
+
+    connect(scrollBackButton_   , SIGNAL(clicked()), this, SLOT(scrollBackSlot()));
+    connect(scrollForwardButton_, SIGNAL(clicked()), this, SLOT(scrollForwardSlot()));
+  }
+
+  scrollPos_ = 0;
+
+  layoutDirty_ = true;
+
+  // wrapped strip has height for width
+  invalidateSizeHints();
+
+  updateLayout(true);
+}
+
+// scroll areas by blitting existing contents (no relayout)
+void
+CQToolStrip::
+setScrollPos(int pos)
+{
+  pos = std::min(std::max(pos, 0), scrollRange_);
+
+  int d = scrollPos_ - pos;
+
+  if (d == 0)
+    return;
+
+  scrollPos_ = pos;
+
+  // moves all children (including scroll buttons) and scrolls contents
+  if (orientation_ == Qt::Horizontal)
+    scroll(d, 0);
+  else
+    scroll(0, d);
+
+  // put scroll buttons back
+  if (orientation_ == Qt::Horizontal)
+    CQToolStripHLayout(this).placeScrollButtons();
+  else
+    CQToolStripVLayout(this).placeScrollButtons();
+}
+
+void
+CQToolStrip::
+scrollBackSlot()
+{
+  setScrollPos(scrollPos_ - stripLength()/2);
+}
+
+void
+CQToolStrip::
+scrollForwardSlot()
+{
+  setScrollPos(scrollPos_ + stripLength()/2);
+}
+
+void
+CQToolStrip::
+wheelEvent(QWheelEvent *e)
+{
+  if (scrollRange_ <= 0) {
+    QWidget::wheelEvent(e);
+    return;
+  }
+
+  QPoint delta = e->angleDelta();
+
+  int d = (delta.y() != 0 ? delta.y() : delta.x());
+
+  // 120 per wheel step
+  setScrollPos(scrollPos_ - d/4);
+}
+
+void
+CQToolStrip::
+mousePressEvent(QMouseEvent *e)
+{
+  if (scrollRange_ <= 0 || e->button() != Qt::LeftButton) {
+    QWidget::mousePressEvent(e);
+    return;
+  }
+
+  dragState_.pressed   = true;
+  dragState_.pressPos  = (orientation_ == Qt::Horizontal ? e->pos().x() : e->pos().y());
+  dragState_.scrollPos = scrollPos_;
+}
+
+void
+CQToolStrip::
+mouseMoveEvent(QMouseEvent *e)
+{
+  if (! dragState_.pressed) {
+    QWidget::mouseMoveEvent(e);
+    return;
+  }
+
+  int pos = (orientation_ == Qt::Horizontal ? e->pos().x() : e->pos().y());
+
+  setScrollPos(dragState_.scrollPos + dragState_.pressPos - pos);
+}
+
+void
+CQToolStrip::
+mouseReleaseEvent(QMouseEvent *e)
+{
+  if (! dragState_.pressed) {
+    QWidget::mouseReleaseEvent(e);
+    return;
+  }
+
+  dragState_.pressed = false;
+}
+
+void
+CQToolStrip::
+cancelProgressiveLayout()
+{
+  if (layoutTimer_)
+    layoutTimer_->stop();
+
+  delete pendingResult_;
+
+  pendingResult_ = 0;
+
+  pendingInds_.clear();
+
+  pendingPos_     = 0;
+  pendingVisible_ = 0;
+}
+
+// area list changing so progressive layout (indexes of old list) can't be finished
+// and full layout is needed
+void
+CQToolStrip::
+dropProgressiveLayout()
+{
+  if (! pendingResult_)
+    return;
+
+  cancelProgressiveLayout();
+
+  layoutDirty_ = true;
+}
+
+// relayout areas from index after area list change
+void
+CQToolStrip::
+updateLayoutFrom(int ind, bool full)
+{
+  LayoutPass pass(this);
+
+  // clipping (or scroll range) may change so need full layout (also if deferred until
+  // shown or collapsed group buttons need placing)
+  if (! full)
+    full = (layoutDirty_ || ! isVisible() || clip_ || scrollRange_ > 0 ||
+            overflowPolicy_ == OverflowWrap || hasCollapsedGroup() ||
+            pendingResult_ || contentsLength() > stripLength());
+
+  if (full) {
+    // keep open menu in sync with new clipped areas
+    bool menuOpen = menu_->isOpen();
+
+    if (menuOpen)
+      menu_->clearActions();
+
+    updateLayout(true);
+
+    if (menuOpen) {
+      menu_->addActions();
+
+      menu_->updateContents();
+    }
+
+    return;
+  }
+
+  menu_->invalidatePrewarm();
+
+  if (orientation_ == Qt::Horizontal)
+    CQToolStripHLayout(this).updateLayoutFrom(ind);
+  else
+    CQToolStripVLayout(this).updateLayoutFrom(ind);
+
+  emitLayoutApplied();
+}
+
+void
+CQToolStrip::
+updateLabelHeight()
+{
+  auto n = areas_.size();
+
+  // determine label height
+  labelHeight_ = 0;
+
+  for (uint i = 0; i < n; ++i) {
+    CQToolStripArea *area = areas_[i];
+
+    area->rowLabelHeight_ = -1;
+
+    if (area->isHiddenByUser()) continue;
+
+    int labelHeight = area->labelMinHeight();
+
+    labelHeight_ = std::max(labelHeight_, labelHeight);
+  }
+//std::cerr << "labelHeight " << labelHeight_ << std::endl;
+}
+
+int
+CQToolStrip::
+contentsLength() const
+{
+  auto *th = const_cast<CQToolStrip *>(this);
+
+  if (orientation_ == Qt::Horizontal)
+    return CQToolStripHLayout(th).contentsLength();
+  else
+    return CQToolStripVLayout(th).contentsLength();
+}
+
+int
+CQToolStrip::
+stripLength() const
+{
+  return (orientation_ == Qt::Horizontal ? width() : height());
+}
+
+void
+CQToolStrip::
+hideSplitters()
+{
+  for (int i = 0; i < splitterPos_; ++i)
+    splitters_[uint(i)]->hide();
+
+  splitterPos_ = 0;
+}
+
+CQToolStripSplitter *
+CQToolStrip::
+getSplitter()
+{
+  while (splitterPos_ >= int(splitters_.size()))
+    splitters_.push_back(new CQToolStripSplitter(this));
+
+  auto *splitter = splitters_[uint(splitterPos_++)];
+
+  return splitter;
+}
+
+void
+CQToolStrip::
+splitterMoved(int ind, int d)
+{
+  LayoutPass pass(this);
+
+  emit splitterDragged(ind, d);
+
+  // user resize replaces any pending solve
+  ++layoutGeneration_;
+
+  finishProgressiveLayout();
+
+  // column width shared with other strips
+  if (columnModel_) {
+    columnModel_->splitterMoved(this, ind, d);
+    return;
+  }
+
+  if (orientation_ == Qt::Horizontal)
+    CQToolStripHLayout(this).splitterMoved(ind, d);
+  else
+    CQToolStripVLayout(this).splitterMoved(ind, d);
+
+  emitLayoutApplied();
+}
+
+QByteArray
+CQToolStrip::
+saveState() const
+{
+  QByteArray state;
+
+  QDataStream ds(&state, QIODevice::WriteOnly);
+
+  ds.setVersion(QDataStream::Qt_5_0);
+
+  ds << stateMagic << stateVersion;
+
+  //---
+
+  // clipped areas are always at end so just save first clipped index
+  auto n = areas_.size();
+
+  int clipInd = firstClippedInd();
+
+  ds << qint32(stripLength()) << qint32(n) << qint32(clipInd);
+
+  //---
+
+  // save user set widths of named areas
+  std::vector<CQToolStripArea *> areas;
+
+  for (uint i = 0; i < n; ++i) {
+    auto *area = areas_[i];
+
+    if (area->hasUserWidth() && ! area->objectName().isEmpty())
+      areas.push_back(area);
+  }
+
+  ds << quint32(areas.size());
+
+  for (const auto *area : areas)
+    ds << area->objectName() << qint32(area->userWidth());
+
+  return state;
+}
+
+bool
+CQToolStrip::
+restoreState(const QByteArray &state)
+{
+  QDataStream ds(state);
+
+  ds.setVersion(QDataStream::Qt_5_0);
+
+  quint32 magic   = 0;
+  quint8  version = 0;
+
+  ds >> magic >> version;
+
+  if (ds.status() != QDataStream::Ok || magic != stateMagic || version != stateVersion)
+    return false;
+
+  qint32 stripWidth = 0, numAreas = 0, clipInd = -1;
+
+  ds >> stripWidth >> numAreas >> clipInd;
+
+  quint32 numWidths = 0;
+
+  ds >> numWidths;
+
+  std::map<QString, int> nameWidths;
+
+  for (quint32 i = 0; i < numWidths && ds.status() == QDataStream::Ok; ++i) {
+    QString name;
+    qint32  w = -1;
+
+    ds >> name >> w;
+
+    nameWidths[name] = w;
+  }
+
+  if (ds.status() != QDataStream::Ok)
+    return false;
+
+  //---
+
+  for (auto *area : areas_) {
+    auto p = nameWidths.find(area->objectName());
+
+    if (p != nameWidths.end())
+      area->setDisplayWidth((*p).second);
+  }
+
+  restoreData_.valid    = true;
+  restoreData_.width    = stripWidth;
+  restoreData_.numAreas = numAreas;
+  restoreData_.clipInd  = clipInd;
+
+  layoutDirty_ = true;
+
+  updateLayout(true);
+
+  return true;
+}
+
+// get restored first clipped area (if restored state still valid)
+bool
+CQToolStrip::
+restoreClipInd(int &clipInd)
+{
+  // restored clipping only valid for first layout and if nothing has changed
+  if (! restoreData_.valid)
+    return false;
+
+  restoreData_.valid = false;
+
+  // groups may need collapsing instead (and nothing is clipped if scrolled)
+  if (! groups_.empty() || overflowPolicy_ == OverflowScroll)
+    return false;
+
+  auto n = areas_.size();
+
+  if (restoreData_.width != stripLength() || restoreData_.numAreas != int(n))
+    return false;
+
+  clipInd = restoreData_.clipInd;
+
+  return true;
+}
+
+QSize
+CQToolStrip::
+sizeHint() const
+{
+  if (! sizeHint_.valid) {
+    auto *th = const_cast<CQToolStrip *>(this);
+
+    if (orientation_ == Qt::Horizontal)
+      sizeHint_.size = CQToolStripHLayout(th).sizeHint();
+    else
+      sizeHint_.size = CQToolStripVLayout(th).sizeHint();
+
+    sizeHint_.valid = true;
+  }
+
+  return sizeHint_.size;
+}
+
+QSize
+CQToolStrip::
+minimumSizeHint() const
+{
+  if (! minSizeHint_.valid) {
+    auto *th = const_cast<CQToolStrip *>(this);
+
+    if (orientation_ == Qt::Horizontal)
+      minSizeHint_.size = CQToolStripHLayout(th).minimumSizeHint();
+    else
+      minSizeHint_.size = CQToolStripVLayout(th).minimumSizeHint();
+
+    minSizeHint_.valid = true;
+  }
+
+  return minSizeHint_.size;
+}
+
+bool
+CQToolStrip::
+hasHeightForWidth() const
+{
+  return (overflowPolicy_ == OverflowWrap && orientation_ == Qt::Horizontal);
+}
+
+int
+CQToolStrip::
+heightForWidth(int w) const
+{
+  if (! hasHeightForWidth())
+    return QWidget::heightForWidth(w);
+
+  auto p = heightForWidth_.find(w);
+
+  if (p == heightForWidth_.end()) {
+    auto *th = const_cast<CQToolStrip *>(this);
+
+    int h = std::max(CQToolStripHLayout(th).wrapBreadth(w), minimumSizeHint().height());
+
+    p = heightForWidth_.insert(p, HeightForWidth::value_type(w, h));
+  }
+
+  return (*p).second;
+}
+
+// invalidate cached size hints (and those of any parent strip)
+void
+CQToolStrip::
+invalidateSizeHints()
+{
+  invalidateSegments();
+
+  invalidateSizeHintCache();
+}
+
+// invalidate cached strip size hints (segment tree still valid)
+void
+CQToolStrip::
+invalidateSizeHintCache()
+{
+  // area sizes (or count) may change column widths
+  if (columnModel_)
+    columnModel_->scheduleUpdate();
+
+  // if not valid then nothing has used the hints since last change
+  if (! sizeHint_.valid && ! minSizeHint_.valid)
+    return;
+
+  // remember hints parent may have used (hints read while comparison is pending
+  // haven't been seen by parent)
+  bool pending = (sizeHintTimer_ && sizeHintTimer_->isActive());
+
+  if (! pending) {
+    if (sizeHint_.valid)
+      sizeHint_.prevSize = sizeHint_.size;
+
+    if (minSizeHint_.valid)
+      minSizeHint_.prevSize = minSizeHint_.size;
+  }
+
+  sizeHint_   .valid = false;
+  minSizeHint_.valid = false;
+
+  // compare once all changes in this event loop iteration are done
+  if (! sizeHintTimer_) {
+    sizeHintTimer_ = new QTimer(this);
+
+    sizeHintTimer_->setSingleShot(true);
+    sizeHintTimer_->setInterval(0);
+
+    connect(sizeHintTimer_, SIGNAL(timeout()), this, SLOT(sizeHintsSlot()));
+  }
+
+  sizeHintTimer_->start();
+}
+
+// notify parent (layout or nested strip) only if size hints changed
+void
+CQToolStrip::
+sizeHintsSlot()
+{
+  if (sizeHint() == sizeHint_.prevSize && minimumSizeHint() == minSizeHint_.prevSize &&
+      ! hasHeightForWidth())
+    return;
+
+  updateGeometry();
+
+  // nested strip
+  auto *area = qobject_cast<CQToolStripArea *>(parentWidget());
+
+  if (area)
+    area->strip()->nestedSizeChanged(area);
+}
+
+// update area length in segment tree
+void
+CQToolStrip::
+areaLengthChanged(CQToolStripArea *area)
+{
+  if (! segmentsValid_)
+    return;
+
+  int ind = area->index_;
+
+  if (ind < 0 || ind >= numAreas() || areas_[uint(ind)] != area) {
+    invalidateSegments();
+    return;
+  }
+
+  if (orientation_ == Qt::Horizontal)
+    CQToolStripHLayout(this).updateSegment(ind);
+  else
+    CQToolStripVLayout(this).updateSegment(ind);
+
+  invalidateRows(ind);
+}
+
+// update area clipped flag in geometry table
+void
+CQToolStrip::
+areaClippedChanged(CQToolStripArea *area)
+{
+  if (! segmentsValid_)
+    return;
+
+  int ind = area->index_;
+
+  if (ind < 0 || ind >= numAreas() || areas_[uint(ind)] != area)
+    return;
+
+  geometry_.setFlag(ind, CQToolStripGeometryTable::Clipped, area->isClipped());
+}
+
+// index of first clipped area (-1 if none)
+int
+CQToolStrip::
+firstClippedInd() const
+{
+  int n = numAreas();
+
+  int ind = n;
+
+  if (segmentsValid_ && geometry_.size() == n)
+    ind = geometry_.firstFlag(CQToolStripGeometryTable::Clipped);
+  else {
+    for (int i = 0; i < n; ++i) {
+      if (areas_[uint(i)]->isClipped()) {
+        ind = i;
+        break;
+      }
+    }
+  }
+
+  return (ind < n ? ind : -1);
+}
+
+// invalidate wrapped rows affected by change to area
+void
+CQToolStrip::
+invalidateRows(int ind)
+{
+  heightForWidth_.clear();
+
+  // previous row may now fit first area of changed row
+  while (! rows_.empty() && rows_.back().end >= ind - 1)
+    rows_.pop_back();
+}
+
+// size hint of area widget changed (coalesced until next event loop iteration)
+void
+CQToolStrip::
+requestAreaRelayout(CQToolStripArea *area)
+{
+  if (std::find(relayoutAreas_.begin(), relayoutAreas_.end(), area) == relayoutAreas_.end())
+    relayoutAreas_.push_back(area);
+
+  if (! relayoutTimer_) {
+    relayoutTimer_ = new QTimer(this);
+
+    relayoutTimer_->setSingleShot(true);
+    relayoutTimer_->setInterval(0);
+
+    connect(relayoutTimer_, SIGNAL(timeout()), this, SLOT(areaRelayoutSlot()));
+  }
+
+  relayoutTimer_->start();
+}
+
+// relayout from first changed area (clipping only updated if boundary crossed)
+void
+CQToolStrip::
+areaRelayoutSlot()
+{
+  LayoutPass pass(this);
+
+  int  ind  = numAreas();
+  bool full = false;
+
+  for (auto *area : relayoutAreas_) {
+    int i = areaIndex(area);
+
+    if (i < 0) continue;
+
+    // update area length in segment tree (and wrapped rows)
+    areaLengthChanged(area);
+
+    // larger label needs full layout
+    if (area->labelMinHeight() > labelHeight_)
+      full = true;
+
+    ind = std::min(ind, i);
+  }
+
+  relayoutAreas_.clear();
+
+  if (ind >= numAreas())
+    return;
+
+  invalidateSizeHintCache();
+
+  // clipped strip only needs visible areas placed if same areas still fit
+  if (! full && clip_ && overflowPolicy_ == OverflowMenu && ! layoutDirty_ && isVisible() &&
+      ! hasCollapsedGroup() && ! pendingResult_) {
+    int visInd = firstClippedInd();
+
+    if (visInd < 0)
+      visInd = numAreas();
+
+    bool valid;
+
+    if (orientation_ == Qt::Horizontal)
+      valid = CQToolStripHLayout(this).isClipValid(visInd);
+    else
+      valid = CQToolStripVLayout(this).isClipValid(visInd);
+
+    if (valid) {
+      if (ind < visInd) {
+        if (orientation_ == Qt::Horizontal)
+          CQToolStripHLayout(this).updateLayoutFrom(ind, visInd);
+        else
+          CQToolStripVLayout(this).updateLayoutFrom(ind, visInd);
+
+        emitLayoutApplied();
+      }
+
+      if (menu_->isOpen())
+        menu_->updateContents();
+      else
+        menu_->invalidatePrewarm();
+
+      return;
+    }
+  }
+
+  updateLayoutFrom(ind, full);
+}
+
+// area hidden/shown by user (update active areas and relayout from area)
+void
+CQToolStrip::
+areaHiddenChanged(CQToolStripArea *area)
+{
+  int ind = areaIndex(area);
+
+  if (ind < 0) {
+    area->setVisible(! area->isHiddenByUser());
+    return;
+  }
+
+  // clipped areas (in menu) and collapsed groups need full layout
+  bool full = (area->isClipped() || hasCollapsedGroup() || overflowPolicy_ != OverflowMenu);
+
+  // hiding largest label may reduce label height (and showing may increase it)
+  int lh = area->labelMinHeight();
+
+  if (lh > 0 && lh >= labelHeight_)
+    full = true;
+
+  // shown area after clipped areas needs clipping
+  if (! full) {
+    int clipInd = firstClippedInd();
+
+    if (clipInd >= 0 && clipInd < ind)
+      full = true;
+  }
+
+  if (full) {
+    invalidateSizeHints();
+
+    updateLayout(true);
+
+    return;
+  }
+
+  if (area->isHiddenByUser())
+    area->hide();
+
+  if (orientation_ == Qt::Horizontal)
+    CQToolStripHLayout(this).updateActiveArea(ind);
+  else
+    CQToolStripVLayout(this).updateActiveArea(ind);
+
+  invalidateSizeHintCache();
+
+  // offsets from area and clipping (if boundary crossed) updated on next event loop
+  requestAreaRelayout(area);
+}
+
+// size of nested strip in area changed
+void
+CQToolStrip::
+nestedSizeChanged(CQToolStripArea *area)
+{
+  invalidateSizeHints();
+
+  int ind = areaIndex(area);
+
+  if (ind >= 0 && ! area->isClipped())
+    updateLayoutFrom(ind, false);
+}
+
+//-------
+
+CQToolStripArea::
+CQToolStripArea(CQToolStrip *strip) :
+ QWidget(strip), strip_(strip), group_(0), index_(-1), w_(0), flags_(NoFlags),
+ alignment_(Qt::AlignLeft | Qt::AlignBottom), label_(0), resizable_(false),
+ displayWidth_(-1), userWidth_(-1), clipped_(false), rowLabelHeight_(-1), hiddenByUser_(false), factory_(0)
+{
+}
+
+void
+CQToolStripArea::
 setWidget(QWidget *w)
 {
   if (w_)
     w_->setParent(0);
 
-  w_ = w;
+  w_ = w;
+
+  if (w_)
+    w_->setParent(this);
+
+  factory_ = 0;
+
+  strip_->invalidateSizeHints();
+}
+
+void
+CQToolStripArea::
+setWidgetFactory(CQToolStripWidgetFactory *factory, const QString &id)
+{
+  factory_   = factory;
+  factoryId_ = id;
+
+  strip_->invalidateSizeHints();
+
+  // keep area hidden (not shown with strip) until layout or menu places it
+  if (isVisible())
+    ensureWidget();
+  else if (isWidgetPending())
+    hide();
+}
+
+void
+CQToolStripArea::
+ensureWidget()
+{
+  if (! isWidgetPending())
+    return;
+
+  QWidget *w = factory_->createWidget(factoryId_);
+
+  if (! w)
+    return;
+
+  w_ = w;
+
+  w_->setParent(this);
+
+  updateLayout();
+
+  w_->show();
+
+  // widget size replaces factory size on next event loop iteration
+  strip_->requestAreaRelayout(this);
+}
+
+bool
+CQToolStripArea::
+setGroup(CQToolStripGroup *group)
+{
+  if (group == group_)
+    return true;
+
+  if (! strip_->canSetAreaGroup(this, group))
+    return false;
+
+  group_ = group;
 
-  if (w_)
-    w_->setParent(this);
+  strip_->invalidateSizeHints();
+
+  strip_->updateLayout(true);
+
+  return true;
 }
 
 void
@@ -556,9 +1914,13 @@ setLabel(const QString &label)
   if (! label_)
     label_ = new QLabel(this);
 
+  labelText_ = label;
+
   QString label1 = QString("<small><bold>%1</bold></small>").arg(label);
 
   label_->setText(label1);
+
+  strip_->invalidateSizeHints();
 }
 
 void
@@ -568,6 +1930,10 @@ unsetLabel()
   delete label_;
 
   label_ = 0;
+
+  labelText_ = "";
+
+  strip_->invalidateSizeHints();
 }
 
 void
@@ -575,13 +1941,27 @@ CQToolStripArea::
 setResizable(bool resizable)
 {
   resizable_ = resizable;
+
+  strip_->invalidateSizeHints();
+}
+
+void
+CQToolStripArea::
+setHiddenByUser(bool hidden)
+{
+  if (hidden == hiddenByUser_)
+    return;
+
+  hiddenByUser_ = hidden;
+
+  strip_->areaHiddenChanged(this);
 }
 
 int
 CQToolStripArea::
 labelMinHeight() const
 {
-  return (label_ ? label_->minimumSizeHint().height() : 0);
+  return labelSize().height();
 }
 
 int
@@ -590,10 +1970,12 @@ labelHeight() const
 {
   QWidget *parent = parentWidget();
 
-  int lh = strip_->labelHeight();
+  // labels aligned across row if wrapped
+  int lh = (rowLabelHeight_ >= 0 ? rowLabelHeight_ : strip_->labelHeight());
 
-  if (! qobject_cast<CQToolStrip *>(parent))
-    lh = (label_ ? label_->minimumSizeHint().height() : 0);
+  // labels only aligned across areas of horizontal strip
+  if (! qobject_cast<CQToolStrip *>(parent) || strip_->orientation() == Qt::Vertical)
+    lh = labelSize().height();
 
   return lh;
 }
@@ -604,16 +1986,45 @@ displayWidth() const
 {
   if (displayWidth_ >= 0)
     return displayWidth_;
-  else
-    return minimumSizeHint().width();
+
+  // nested strip defaults to preferred size (can be shrunk by strip)
+  QSize s = (nestedStrip() ? sizeHint() : minimumSizeHint());
+
+  return (strip_->orientation() == Qt::Horizontal ? s.width() : s.height());
 }
 
 void
 CQToolStripArea::
 setDisplayWidth(int w)
+{
+  userWidth_ = w;
+
+  setLayoutWidth(w);
+}
+
+void
+CQToolStripArea::
+setLayoutWidth(int w)
 {
 //std::cerr << "set display width " << w << std::endl;
   displayWidth_ = w;
+
+  strip_->areaLengthChanged(this);
+}
+
+// widget (or label) size hint changed
+bool
+CQToolStripArea::
+event(QEvent *e)
+{
+  if (e->type() == QEvent::LayoutRequest && w_ && ! nestedStrip())
+    strip_->requestAreaRelayout(this);
+
+  // create pending widget when area first shown (in strip or menu)
+  if (e->type() == QEvent::Show && isWidgetPending())
+    ensureWidget();
+
+  return QWidget::event(e);
 }
 
 void
@@ -642,7 +2053,12 @@ void
 CQToolStripArea::
 setClipped(bool clipped)
 {
+  if (clipped == clipped_)
+    return;
+
   clipped_ = clipped;
+
+  strip_->areaClippedChanged(this);
 }
 
 bool
@@ -657,17 +2073,62 @@ QSize
 CQToolStripArea::
 sizeHint() const
 {
-  int lh = labelHeight();
+  return calcSizeHint(labelHeight());
+}
+
+QSize
+CQToolStripArea::
+minimumSizeHint() const
+{
+  return calcMinimumSizeHint(labelHeight());
+}
+
+QSize
+CQToolStripArea::
+menuSizeHint() const
+{
+  return calcSizeHint(labelMinHeight());
+}
+
+QSize
+CQToolStripArea::
+menuMinimumSizeHint() const
+{
+  return calcMinimumSizeHint(labelMinHeight());
+}
+
+// label minimum size (from metric cache if enabled)
+QSize
+CQToolStripArea::
+labelSize() const
+{
+  if (! label_)
+    return QSize(0, 0);
+
+  return CQToolStripMetricCache::instance()->labelSize(label_);
+}
 
+QSize
+CQToolStripArea::
+calcSizeHint(int lh) const
+{
   int w = 0, h = 0;
 
   if (w_) {
-    w = w_->sizeHint().width();
-    h = w_->sizeHint().height();
+    QSize s = CQToolStripMetricCache::instance()->widgetMetrics(w_).sizeHint;
+
+    w = s.width ();
+    h = s.height();
+  }
+  else if (factory_) {
+    QSize s = factory_->sizeHint(factoryId_);
+
+    w = s.width ();
+    h = s.height();
   }
 
   if (label_) {
-    QSize ls = label_->minimumSizeHint();
+    QSize ls = labelSize();
 
     w  = std::max(w, ls.width());
     h += lh;
@@ -679,17 +2140,17 @@ sizeHint() const
 
 QSize
 CQToolStripArea::
-minimumSizeHint() const
+calcMinimumSizeHint(int lh) const
 {
-  int lh = labelHeight();
-
   QSize s;
 
-  if (w_)
-    s = CQWidgetUtil::SmartMinSize(w_);
+  if      (w_)
+    s = CQToolStripMetricCache::instance()->widgetMetrics(w_).minSize;
+  else if (factory_)
+    s = factory_->minimumSizeHint(factoryId_);
 
   if (label_) {
-    QSize ls = label_->minimumSizeHint();
+    QSize ls = labelSize();
 
     s = QSize(std::max(s.width(), ls.width()), s.height() + lh);
   }
@@ -700,6 +2161,48 @@ minimumSizeHint() const
 
 //------
 
+CQToolStripGroup::
+CQToolStripGroup(CQToolStrip *strip, const QString &name) :
+ QObject(strip), strip_(strip), name_(name), collapsed_(false), autoCollapsed_(false),
+ startInd_(-1), endInd_(-1), button_(0)
+{
+  setObjectName(name);
+}
+
+void
+CQToolStripGroup::
+setCollapsed(bool collapsed)
+{
+  if (collapsed == collapsed_)
+    return;
+
+  collapsed_ = collapsed;
+
+  strip_->invalidateSizeHints();
+
+  strip_->updateLayout(true);
+}
+
+CQToolStripGroupButton *
+CQToolStripGroup::
+button()
+{
+  if (! button_)
+    button_ = new CQToolStripGroupButton(this);
+
+  return button_;
+}
+
+void
+CQToolStripGroup::
+hideButton()
+{
+  if (button_)
+    button_->hide();
+}
+
+//------
+
 CQToolStripSplitter::
 CQToolStripSplitter(CQToolStrip *strip) :
  QWidget(strip), strip_(strip), ind_(-1), orient_(Qt::Vertical), mouseOver_(false)
@@ -825,6 +2328,13 @@ CQToolStripMenuButton(CQToolStrip *strip) :
 
   setFixedSize(ext + 2, ext + 2);
 
+  updateIcon();
+}
+
+void
+CQToolStripMenuButton::
+updateIcon()
+{
   QStyleOption opt;
 
   opt.init(this);
@@ -835,6 +2345,16 @@ CQToolStripMenuButton(CQToolStrip *strip) :
     setIcon(style()->standardIcon(QStyle::SP_ToolBarVerticalExtensionButton, &opt));
 }
 
+void
+CQToolStripMenuButton::
+mousePressEvent(QMouseEvent *e)
+{
+  // time from press to menu shown
+  strip_->menu_->startLatencyTimer();
+
+  QToolButton::mousePressEvent(e);
+}
+
 void
 CQToolStripMenuButton::
 paintEvent(QPaintEvent *)
@@ -853,9 +2373,30 @@ paintEvent(QPaintEvent *)
 
 //------
 
+CQToolStripGroupButton::
+CQToolStripGroupButton(CQToolStripGroup *group) :
+ QToolButton(group->strip()), group_(group)
+{
+  setObjectName("group_button");
+
+  setFocusPolicy(Qt::NoFocus);
+
+  setAutoRaise(true);
+
+  setText(group->name());
+
+  setPopupMode(QToolButton::InstantPopup);
+
+  setMenu(new CQToolStripMenu(group->strip(), group));
+
+  setVisible(false);
+}
+
+//------
+
 CQToolStripMenu::
-CQToolStripMenu(CQToolStrip *strip) :
- CQFrameMenu(true), strip_(strip)
+CQToolStripMenu(CQToolStrip *strip, CQToolStripGroup *group) :
+ CQFrameMenu(true), strip_(strip), group_(group), prewarmed_(false), relayoutTime_(0.0)
 {
   setObjectName("menu");
 
@@ -871,25 +2412,144 @@ void
 CQToolStripMenu::
 addActions()
 {
-  // add clipped items to menu
+  // group menu isn't invalidated when strip areas change so always get its areas
+  if (! prewarmed_ || group_)
+    prewarm();
+
+  for (auto *area : prewarmAreas_)
+    contents_->addArea(area);
+
+  contents_->resetFilter();
+}
+
+// get menu areas and their size (so show only needs to reparent them)
+void
+CQToolStripMenu::
+prewarm()
+{
+  prewarmAreas_.clear();
+
+  // clipped items (or collapsed group items)
   int n = strip_->numAreas();
 
   for (int i = 0; i < n; ++i) {
     CQToolStripArea *area = strip_->getArea(i);
 
-    if (! area->isClipped()) continue;
+    if (group_) {
+      if (area->group() != group_ || area->isClipped() || area->isHiddenByUser()) continue;
+    }
+    else {
+      if (! area->isClipped()) continue;
+    }
+
+    prewarmAreas_.push_back(area);
+  }
 
-    contents_->addArea(area);
+  updateSearchIndex();
+
+  CQFrameMenu::prewarm(contents_->areasMinimumSize(prewarmAreas_));
+
+  prewarmed_ = true;
+}
+
+// search by label and name (indices match menu areas)
+void
+CQToolStripMenu::
+updateSearchIndex()
+{
+  std::vector<QString> strs;
+
+  for (const auto *area : prewarmAreas_) {
+    QString str = area->labelText() + " " + area->objectName();
+
+    if (area->widget())
+      str += " " + area->widget()->objectName();
+
+    strs.push_back(str);
+  }
+
+  searchIndex_.build(strs);
+}
+
+void
+CQToolStripMenu::
+startLatencyTimer()
+{
+  latencyTimer_.start();
+}
+
+void
+CQToolStripMenu::
+popupPaintEvent()
+{
+  if (latencyTimer_.isValid()) {
+    double ms = double(latencyTimer_.nsecsElapsed())/1e6;
+
+    latencyTimer_.invalidate();
+
+    strip_->setPopupLatency(ms);
   }
 }
 
+size_t
+CQToolStripMenu::
+memoryBytes() const
+{
+  return CQToolStripMemory::vectorBytes(prewarmAreas_) + searchIndex_.memoryBytes() +
+         contents_->memoryBytes();
+}
+
 void
 CQToolStripMenu::
 removeActions()
 {
-  contents_->removeAreas(strip_);
+  clearActions();
+
+  QElapsedTimer timer;
+
+  if (isPhaseTiming())
+    timer.start();
 
   strip_->updateLayout(true);
+
+  if (timer.isValid())
+    relayoutTime_ = timer.nsecsElapsed()/1e6;
+}
+
+// return areas to strip without strip relayout
+void
+CQToolStripMenu::
+clearActions()
+{
+  contents_->removeAreas(strip_);
+}
+
+void
+CQToolStripMenu::
+removeArea(CQToolStripArea *area)
+{
+  invalidatePrewarm();
+
+  // following areas move down so search indices must be rebuilt
+  auto p = std::find(prewarmAreas_.begin(), prewarmAreas_.end(), area);
+
+  if (p != prewarmAreas_.end()) {
+    prewarmAreas_.erase(p);
+
+    updateSearchIndex();
+  }
+
+  contents_->removeArea(area);
+}
+
+// update open menu for changed areas
+void
+CQToolStripMenu::
+updateContents()
+{
+  contents_->updateAreas();
+
+  CQFrameMenu::updateContents();
 }
 
 //------
@@ -898,12 +2558,23 @@ CQToolStripMenuContents::
 CQToolStripMenuContents(CQToolStripMenu *menu) :
  QWidget(0), menu_(menu)
 {
+  search_ = new QLineEdit(this);
+
+  search_->setObjectName("search");
+  search_->setPlaceholderText("Search");
+  search_->setClearButtonEnabled(true);
+
+  connect(search_, SIGNAL(textChanged(const QString &)), this, SLOT(filterSlot(const QString &)));
 }
 
 void
 CQToolStripMenuContents::
 addArea(CQToolStripArea *area)
 {
+  // already added (menu synced by both strip relayout and solved layout)
+  if (std::find(areas_.begin(), areas_.end(), area) != areas_.end())
+    return;
+
   areas_.push_back(area);
 
   area->setParent(this);
@@ -914,13 +2585,96 @@ void
 CQToolStripMenuContents::
 removeAreas(QWidget *parent)
 {
-  for (uint i = 0; i < areas_.size(); ++i) {
+  // areas stay hidden until strip layout places them (so pending widgets are only
+  // created for areas which fit)
+  for (uint i = 0; i < areas_.size(); ++i)
     areas_[i]->setParent(parent);
 
-    areas_[i]->show();
+  areas_.clear();
+}
+
+void
+CQToolStripMenuContents::
+removeArea(CQToolStripArea *area)
+{
+  auto p = std::find(areas_.begin(), areas_.end(), area);
+
+  if (p != areas_.end())
+    areas_.erase(p);
+
+  // match indices refer to rebuilt search index
+  matches_ = menu_->searchIndex_.match(filter_);
+
+  updateAreas();
+}
+
+void
+CQToolStripMenuContents::
+resetFilter()
+{
+  search_->blockSignals(true);
+
+  search_->clear();
+
+  search_->blockSignals(false);
+
+  filter_ = "";
+
+  matches_ = menu_->searchIndex_.match(filter_);
+}
+
+// show areas matching search text
+void
+CQToolStripMenuContents::
+filterSlot(const QString &text)
+{
+  const auto &index = menu_->searchIndex_;
+  const auto &areas = menu_->prewarmAreas_;
+
+  // longer search text only needs previous matches checking
+  Inds matches;
+
+  if (filter_ != "" && text.startsWith(filter_, Qt::CaseInsensitive))
+    matches = index.match(text, matches_);
+  else
+    matches = index.match(text);
+
+  // only change visibility of areas which changed
+  Inds hideInds, showInds;
+
+  std::set_difference(matches_.begin(), matches_.end(), matches.begin(), matches.end(),
+                      std::back_inserter(hideInds));
+  std::set_difference(matches.begin(), matches.end(), matches_.begin(), matches_.end(),
+                      std::back_inserter(showInds));
+
+  for (int i : hideInds) {
+    auto *area = areas[uint(i)];
+
+    if (area->parentWidget() == this)
+      area->hide();
   }
 
-  areas_.clear();
+  for (int i : showInds) {
+    auto *area = areas[uint(i)];
+
+    if (area->parentWidget() == this)
+      area->show();
+  }
+
+  filter_  = text;
+  matches_ = matches;
+
+  updateLayout();
+}
+
+void
+CQToolStripMenuContents::
+updateAreas()
+{
+  updateGeometry();
+
+  if (isVisible())
+    updateLayout();
 }
 
 void
@@ -928,6 +2682,8 @@ CQToolStripMenuContents::
 showEvent(QShowEvent *)
 {
   updateLayout();
+
+  search_->setFocus();
 }
 
 void
@@ -944,9 +2700,19 @@ updateLayout()
   int x = 2;
   int y = 2;
 
+  int sh = search_->sizeHint().height();
+
+  search_->move(x, y);
+  search_->resize(width() - 4, sh);
+
+  y += sh + 2;
+
+  // areas not matching search are hidden
   for (uint i = 0; i < areas_.size(); ++i) {
     CQToolStripArea *area = areas_[i];
 
+    if (area->isHidden()) continue;
+
     QSize s  = area->sizeHint();
     QSize ms = area->minimumSizeHint();
 
@@ -965,8 +2731,10 @@ QSize
 CQToolStripMenuContents::
 sizeHint() const
 {
-  int w = 0;
-  int h = 2;
+  QSize ss = search_->sizeHint();
+
+  int w = ss.width();
+  int h = ss.height() + 4;
 
   for (uint i = 0; i < areas_.size(); ++i) {
     CQToolStripArea *area = areas_[i];
@@ -985,13 +2753,22 @@ QSize
 CQToolStripMenuContents::
 minimumSizeHint() const
 {
-  int w = 0;
-  int h = 2;
+  return areasMinimumSize(areas_);
+}
 
-  for (uint i = 0; i < areas_.size(); ++i) {
-    CQToolStripArea *area = areas_[i];
+QSize
+CQToolStripMenuContents::
+areasMinimumSize(const std::vector<CQToolStripArea *> &areas) const
+{
+  QSize ss = search_->minimumSizeHint();
+
+  int w = ss.width();
+  int h = search_->sizeHint().height() + 4;
 
-    QSize s = area->minimumSizeHint();
+  for (uint i = 0; i < areas.size(); ++i) {
+    CQToolStripArea *area = areas[i];
+
+    QSize s = area->menuMinimumSizeHint();
 
     w = std::max(w, s.width());
 
@@ -1000,3 +2777,12 @@ minimumSizeHint() const
 
   return QSize(w + 4, h);
 }
+
+size_t
+CQToolStripMenuContents::
+memoryBytes() const
+{
+  using namespace CQToolStripMemory;
+
+  return vectorBytes(areas_) + vectorBytes(matches_) + stringBytes(filter_);
+}
@@ -4,7 +4,7 @@ TARGET = CQToolStrip
 
 DEPENDPATH += .
 
-QT += widgets
+QT += widgets concurrent
 
 CONFIG += staticlib
 
@@ -12,10 +12,26 @@ CONFIG += staticlib
 HEADERS += \
 ../include/CQToolStrip.h \
 ../include/CQFrameMenu.h \
+../include/CQToolStripMetricCache.h \
+../include/CQToolStripSegmentTree.h \
+../include/CQToolStripGeometryTable.h \
+../include/CQToolStripSearchIndex.h \
+../include/CQToolStripColumnModel.h \
+../include/CQToolStripRecorder.h \
+../include/CQToolStripSpec.h \
+../include/CQToolStripMemory.h \
+CQToolStripLayout.h \
+CQToolStripLayoutSolver.h \
 
 SOURCES += \
 CQToolStrip.cpp \
 CQFrameMenu.cpp \
+CQToolStripMetricCache.cpp \
+CQToolStripLayoutSolver.cpp \
+CQToolStripSearchIndex.cpp \
+CQToolStripColumnModel.cpp \
+CQToolStripRecorder.cpp \
+CQToolStripSpec.cpp \
 
 OBJECTS_DIR = ../obj
 
@@ -0,0 +1,242 @@
+#include <CQToolStripColumnModel.h>
+#include <CQToolStrip.h>
+#include <CQToolStripLayout.h>
+#include <QTimer>
+#include <algorithm>
+
+namespace {
+
+int sizeLength(const CQToolStrip *strip, const QSize &s) {
+  return (strip->orientation() == Qt::Horizontal ? s.width() : s.height());
+}
+
+}
+
+CQToolStripColumnModel::
+CQToolStripColumnModel(QObject *parent) :
+ QObject(parent), timer_(0)
+{
+}
+
+CQToolStripColumnModel::
+~CQToolStripColumnModel()
+{
+  for (auto *strip : strips_)
+    strip->columnModel_ = 0;
+}
+
+void
+CQToolStripColumnModel::
+addStrip(CQToolStrip *strip)
+{
+  if (std::find(strips_.begin(), strips_.end(), strip) != strips_.end())
+    return;
+
+  if (strip->columnModel_)
+    strip->columnModel_->removeStrip(strip);
+
+  strips_.push_back(strip);
+
+  strip->columnModel_ = this;
+
+  connect(strip, SIGNAL(destroyed(QObject *)), this, SLOT(stripDestroyed(QObject *)));
+
+  scheduleUpdate();
+}
+
+void
+CQToolStripColumnModel::
+removeStrip(CQToolStrip *strip)
+{
+  auto p = std::find(strips_.begin(), strips_.end(), strip);
+
+  if (p == strips_.end())
+    return;
+
+  strips_.erase(p);
+
+  strip->columnModel_ = 0;
+
+  disconnect(strip, SIGNAL(destroyed(QObject *)), this, SLOT(stripDestroyed(QObject *)));
+
+  scheduleUpdate();
+}
+
+void
+CQToolStripColumnModel::
+stripDestroyed(QObject *obj)
+{
+  // strip is already destroyed so only remove pointer
+  auto p = std::find(strips_.begin(), strips_.end(), obj);
+
+  if (p != strips_.end())
+    strips_.erase(p);
+
+  scheduleUpdate();
+}
+
+void
+CQToolStripColumnModel::
+setColumnWidth(int i, int w)
+{
+  if (i < 0)
+    return;
+
+  if (i >= int(userWidths_.size()))
+    userWidths_.resize(uint(i + 1), -1);
+
+  userWidths_[uint(i)] = w;
+
+  updateColumns();
+}
+
+void
+CQToolStripColumnModel::
+splitterMoved(CQToolStrip *strip, int ind, int d)
+{
+  if (std::find(strips_.begin(), strips_.end(), strip) == strips_.end())
+    return;
+
+  if (ind < 0 || ind >= numColumns() || ind >= strip->numAreas())
+    return;
+
+  // drag is relative to area width shown in strip (solved width may be pending)
+  int w = strip->getArea(ind)->displayWidth();
+
+  setColumnWidth(ind, std::max(w + d, minWidths_[uint(ind)]));
+}
+
+void
+CQToolStripColumnModel::
+scheduleUpdate()
+{
+  if (! timer_) {
+    timer_ = new QTimer(this);
+
+    timer_->setSingleShot(true);
+    timer_->setInterval(0);
+
+    connect(timer_, SIGNAL(timeout()), this, SLOT(updateSlot()));
+  }
+
+  timer_->start();
+}
+
+void
+CQToolStripColumnModel::
+updateSlot()
+{
+  updateColumns();
+}
+
+void
+CQToolStripColumnModel::
+updateColumns()
+{
+  typedef CQToolStripSpacing Spacing;
+
+  if (timer_)
+    timer_->stop();
+
+  uint nc = 0;
+
+  for (auto *strip : strips_)
+    nc = std::max(nc, uint(strip->numAreas()));
+
+  widths_   .assign(nc, 0);
+  minWidths_.assign(nc, 0);
+
+  userWidths_.resize(nc, -1);
+
+  std::vector<bool> resizable(nc, false);
+
+  // column widths are largest area width in column
+  int length = -1; // shortest length available for columns
+
+  for (auto *strip : strips_) {
+    int n = strip->numAreas();
+
+    // no splitter after last area not hidden by user
+    int lastActive = -1;
+
+    for (int i = 0; i < n; ++i) {
+      if (! strip->getArea(i)->isHiddenByUser())
+        lastActive = i;
+    }
+
+    int fixedLen = Spacing::margin;
+
+    for (int i = 0; i < n; ++i) {
+      auto *area = strip->getArea(i);
+
+      // hidden area takes no space (column width from other strips)
+      if (area->isHiddenByUser())
+        continue;
+
+      // nested strip defaults to preferred size (see CQToolStripArea::displayWidth)
+      QSize s = (area->nestedStrip() ? area->sizeHint() : area->minimumSizeHint());
+
+      widths_   [uint(i)] = std::max(widths_   [uint(i)], sizeLength(strip, s));
+      minWidths_[uint(i)] = std::max(minWidths_[uint(i)],
+                                     sizeLength(strip, area->minimumSizeHint()));
+
+      if (area->isResizable())
+        resizable[uint(i)] = true;
+
+      fixedLen += Spacing::gap;
+
+      if (area->isResizable() && i < lastActive)
+        fixedLen += Spacing::splitter;
+    }
+
+    if (! strip->isVisible())
+      continue;
+
+    int len = sizeLength(strip, strip->size()) - fixedLen;
+
+    length = (length < 0 ? len : std::min(length, len));
+  }
+
+  for (uint i = 0; i < nc; ++i) {
+    if (userWidths_[i] >= 0)
+      widths_[i] = std::max(userWidths_[i], minWidths_[i]);
+  }
+
+  // shrink resizable columns (last first) to fit shortest strip
+  if (length >= 0) {
+    int d = -length;
+
+    for (uint i = 0; i < nc; ++i)
+      d += widths_[i];
+
+    for (int i = int(nc) - 1; i >= 0 && d > 0; --i) {
+      if (! resizable[uint(i)])
+        continue;
+
+      int newWidth = std::max(widths_[uint(i)] - d, minWidths_[uint(i)]);
+
+      d -= widths_[uint(i)] - newWidth;
+
+      widths_[uint(i)] = newWidth;
+    }
+  }
+
+  //---
+
+  // set all widths before any layout so each strip is laid out once
+  for (auto *strip : strips_) {
+    int n = strip->numAreas();
+
+    for (int i = 0; i < n; ++i) {
+      auto *area = strip->getArea(i);
+
+      if (area->displayWidth() != widths_[uint(i)])
+        area->setLayoutWidth(widths_[uint(i)]);
+    }
+  }
+
+  for (auto *strip : strips_)
+    strip->updateLayout(true);
+
+  emit columnsChanged();
+}
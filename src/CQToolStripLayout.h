@@ -0,0 +1,1271 @@
+#ifndef CQToolStripLayout_H
+#define CQToolStripLayout_H
+
+/*!
+ * Layout core for CQToolStrip.
+ *
+ * Areas are placed along the strip 'length' (x for horizontal, y for vertical) and
+ * fill the strip 'breadth'. The axis and spacing policies are template parameters so
+ * each orientation gets its own specialized layout code.
+ */
+
+#include <CQToolStrip.h>
+#include <CQToolStripSegmentTree.h>
+#include <CQToolStripLayoutSolver.h>
+#include <map>
+#include <algorithm>
+
+//! spacing between areas
+struct CQToolStripSpacing {
+  static constexpr int margin         = 2; // space before first area
+  static constexpr int gap            = 2; // space after each area
+  static constexpr int splitter       = 4; // splitter size
+  static constexpr int splitterOffset = 1; // splitter overlap into preceding gap
+  static constexpr int minLength      = 32; // strip minimum length (room for menu button)
+};
+
+//! horizontal strip (areas placed left to right)
+struct CQToolStripHAxis {
+  static constexpr Qt::Orientation splitterOrient = Qt::Vertical;
+
+  static constexpr Qt::ArrowType backArrow    = Qt::LeftArrow;
+  static constexpr Qt::ArrowType forwardArrow = Qt::RightArrow;
+
+  static int length (const QSize &s) { return s.width (); }
+  static int breadth(const QSize &s) { return s.height(); }
+
+  static int pos(const QWidget *w) { return w->x(); }
+
+  static QPoint point(int pos, int offset) { return QPoint(pos, offset); }
+
+  static QSize size(int length, int breadth) { return QSize(length, breadth); }
+};
+
+//! vertical strip (areas placed top to bottom)
+struct CQToolStripVAxis {
+  static constexpr Qt::Orientation splitterOrient = Qt::Horizontal;
+
+  static constexpr Qt::ArrowType backArrow    = Qt::UpArrow;
+  static constexpr Qt::ArrowType forwardArrow = Qt::DownArrow;
+
+  static int length (const QSize &s) { return s.height(); }
+  static int breadth(const QSize &s) { return s.width (); }
+
+  static int pos(const QWidget *w) { return w->y(); }
+
+  static QPoint point(int pos, int offset) { return QPoint(offset, pos); }
+
+  static QSize size(int length, int breadth) { return QSize(breadth, length); }
+};
+
+//---
+
+template<typename Axis, typename Spacing=CQToolStripSpacing>
+class CQToolStripLayoutT {
+ public:
+  explicit CQToolStripLayoutT(CQToolStrip *strip) :
+   strip_(strip), rowOffset_(0), rowBreadth_(-1) {
+  }
+
+  //! wrapped layout or reposition areas (full unwrapped layout is solved by strip
+  //! and applied by applyResult)
+  void updateLayout();
+
+  //! reposition areas from index to end (no clipping)
+  void updateLayoutFrom(int ind, int end=-1);
+
+  //! check if clipping is unchanged (visible areas fit, first clipped doesn't and
+  //! all areas don't fit without menu button)
+  bool isClipValid(int visInd) const;
+
+  //! rebuild area length tree and group ranges
+  void updateSegments();
+
+  //! update length of single area in tree
+  void updateSegment(int ind);
+
+  //! update active area index and tree after area hidden/shown by user
+  void updateActiveArea(int ind);
+
+  int contentsLength() const;
+
+  void splitterMoved(int ind, int d);
+
+  QSize sizeHint() const;
+  QSize minimumSizeHint() const;
+
+  //! snapshot area metrics for off thread solve
+  CQToolStripLayoutInput snapshot() const;
+
+  //! apply solved layout (only changed geometry is updated)
+  void applyResult(const CQToolStripLayoutResult &result);
+
+  //! apply solved layout in steps: state (lengths, clipping), each area and then
+  //! splitters and buttons
+  void applyState   (const CQToolStripLayoutResult &result);
+  void applyArea    (const CQToolStripLayoutResult &result, uint i);
+  void applyControls(const CQToolStripLayoutResult &result);
+
+  //! update scroll range and scroll buttons (scroll overflow policy)
+  void updateScrollButtons();
+
+  //! place scroll buttons at strip ends
+  void placeScrollButtons();
+
+  //! breadth of areas wrapped at length (wrap overflow policy)
+  int wrapBreadth(int length) const;
+
+ private:
+  void placeArea(uint i, int &pos);
+
+  void placeGroupButton(CQToolStripGroup *group, int &pos);
+
+  // last area of unit (group or single area) starting at area
+  uint unitEnd(uint i) const;
+
+  // copy area state (length, splitter, flags) to geometry table
+  void updateGeometry(uint i);
+
+  // length of splitter after area
+  int splitterLength(uint i) const;
+
+  // index of last area not hidden by user (-1 if none)
+  int lastActiveInd() const;
+
+  int collapsedLength(CQToolStripGroup *group) const;
+
+  // length of unit starting at area (in wrapped row)
+  int unitLength(uint i) const;
+
+  // wrap areas onto rows (re-break from first row which changes)
+  void updateWrapLayout();
+
+  int breakRows(int length, CQToolStrip::Rows &rows) const;
+
+  void updateRowBreadth(CQToolStrip::Row &row) const;
+
+  static int rowsBreadth(const CQToolStrip::Rows &rows);
+
+  void ensureSegments() const;
+
+  void expandToFit(int stopInd=-1, int fitLen=-1);
+
+  // offset of areas for scroll overflow policy
+  int scrollOffset() const;
+
+  int stripLength () const { return Axis::length (strip_->size()); }
+  int stripBreadth() const { return Axis::breadth(strip_->size()); }
+
+  // breadth of placed areas (row breadth if wrapped)
+  int areaBreadth() const { return (rowBreadth_ >= 0 ? rowBreadth_ : stripBreadth()); }
+
+  static int minLength(const CQToolStripArea *area) {
+    return Axis::length(area->minimumSizeHint());
+  }
+
+ private:
+  CQToolStrip *strip_;
+  int          rowOffset_;  // breadth offset of placed areas (wrapped row)
+  int          rowBreadth_; // breadth of placed areas (-1 for strip breadth)
+};
+
+typedef CQToolStripLayoutT<CQToolStripHAxis> CQToolStripHLayout;
+typedef CQToolStripLayoutT<CQToolStripVAxis> CQToolStripVLayout;
+
+//---
+
+template<typename Axis, typename Spacing>
+void
+CQToolStripLayoutT<Axis, Spacing>::
+updateLayout()
+{
+  if (strip_->overflowPolicy() == CQToolStrip::OverflowWrap) {
+    updateWrapLayout();
+    return;
+  }
+
+  auto &areas = strip_->areas_;
+
+  auto n = areas.size();
+
+  // reposition areas (lengths from geometry table)
+  ensureSegments();
+
+  const auto &geometry = strip_->geometry_;
+
+  int splitterNum = 0;
+
+  int pos = Spacing::margin - scrollOffset();
+
+  for (uint i = 0; i < n; ) {
+    uint j = unitEnd(i);
+
+    auto *group = areas[i]->group();
+
+    if (group && group->isShownCollapsed() && ! areas[i]->isClipped()) {
+      group->button()->move(Axis::point(pos, 0));
+
+      pos += collapsedLength(group);
+
+      i = j + 1;
+
+      continue;
+    }
+
+    for (uint k = i; k <= j; ++k) {
+      if (geometry.hasFlag(int(k), CQToolStripGeometryTable::Hidden)) continue;
+
+      auto *area = areas[k];
+
+      int len = geometry.length(int(k));
+
+      area->move  (Axis::point(pos, 0));
+      area->resize(Axis::size(len, stripBreadth()));
+
+      pos += len + Spacing::gap;
+
+      if (geometry.splitter(int(k)) > 0) {
+        auto *splitter = strip_->splitters_[uint(splitterNum++)];
+
+        splitter->move(Axis::point(pos - Spacing::splitterOffset, 0));
+
+        pos += Spacing::splitter;
+      }
+    }
+
+    i = j + 1;
+  }
+}
+
+template<typename Axis, typename Spacing>
+void
+CQToolStripLayoutT<Axis, Spacing>::
+updateLayoutFrom(int ind, int end)
+{
+  auto &areas = strip_->areas_;
+
+  auto n = (end >= 0 ? uint(end) : areas.size());
+
+  ensureSegments();
+
+  const auto &active = strip_->activeInds_;
+
+  // previous (active) area may need splitter added/removed
+  auto p = std::lower_bound(active.begin(), active.end(), ind);
+
+  uint start = (p != active.begin() ? uint(*(p - 1)) : 0);
+
+  // position and splitters of areas before start are unchanged
+  int pos = Spacing::margin - scrollOffset();
+
+  p = std::lower_bound(active.begin(), active.end(), int(start));
+
+  if (p != active.begin()) {
+    uint prev = uint(*(p - 1));
+
+    auto *area = areas[prev];
+
+    pos = Axis::pos(area) + Axis::length(area->size()) + Spacing::gap + splitterLength(prev);
+  }
+
+  int oldSplitterPos = strip_->splitterPos_;
+
+  strip_->splitterPos_ = 0;
+
+  for (uint i = 0; i < start; ++i) {
+    if (splitterLength(i) > 0)
+      ++strip_->splitterPos_;
+  }
+
+  for (uint i = start; i < n; ++i) {
+    auto *area = areas[i];
+
+    area->setClipped(false);
+    area->setVisible(! area->isHiddenByUser());
+
+    placeArea(i, pos);
+  }
+
+  for (int i = strip_->splitterPos_; i < oldSplitterPos; ++i)
+    strip_->splitters_[uint(i)]->hide();
+}
+
+// check areas before visInd still fit and area at visInd still doesn't (so clipping
+// is unchanged and only visible areas need placing). Clipping is invalid if all
+// areas now fit without the menu button
+template<typename Axis, typename Spacing>
+bool
+CQToolStripLayoutT<Axis, Spacing>::
+isClipValid(int visInd) const
+{
+  ensureSegments();
+
+  const auto &lengths = strip_->lengths_;
+
+  if (visInd < 0 || visInd >= int(strip_->areas_.size()))
+    return false;
+
+  if (contentsLength() <= stripLength())
+    return false;
+
+  int length = stripLength() - Axis::length(strip_->menuButton_->size());
+
+  int pos = Spacing::margin + (visInd > 0 ? lengths.sum(0, visInd - 1) : 0);
+
+  // visible areas must still fit
+  if (visInd > 0 && pos - splitterLength(uint(visInd - 1)) > length)
+    return false;
+
+  // first clipped unit must still not fit
+  uint j = unitEnd(uint(visInd));
+
+  return (pos + lengths.sum(visInd, int(j)) - splitterLength(j) > length);
+}
+
+// place area (and following splitter) at pos
+template<typename Axis, typename Spacing>
+void
+CQToolStripLayoutT<Axis, Spacing>::
+placeArea(uint i, int &pos)
+{
+  auto *area = strip_->areas_[i];
+
+  if (area->isHiddenByUser())
+    return;
+
+  area->updateLayout();
+
+  int len = area->displayWidth();
+
+  area->move  (Axis::point(pos, rowOffset_));
+  area->resize(Axis::size(len, areaBreadth()));
+
+  pos += len + Spacing::gap;
+
+  if (splitterLength(i) > 0) {
+    CQToolStripSplitter *splitter = strip_->getSplitter();
+
+    splitter->init(int(i), Axis::splitterOrient);
+
+    splitter->move  (Axis::point(pos - Spacing::splitterOffset, rowOffset_));
+    splitter->resize(Axis::size(Spacing::splitter, areaBreadth()));
+
+    splitter->show();
+
+    QObject::connect(splitter, SIGNAL(splitterMoved(int, int)),
+                     strip_, SLOT(splitterMoved(int, int)), Qt::UniqueConnection);
+
+    pos += Spacing::splitter;
+  }
+}
+
+// place button of collapsed group at pos
+template<typename Axis, typename Spacing>
+void
+CQToolStripLayoutT<Axis, Spacing>::
+placeGroupButton(CQToolStripGroup *group, int &pos)
+{
+  auto *button = group->button();
+
+  int len = Axis::length(button->sizeHint());
+
+  button->move  (Axis::point(pos, rowOffset_));
+  button->resize(Axis::size(len, areaBreadth()));
+
+  button->show();
+  button->raise();
+
+  pos += len + Spacing::gap;
+}
+
+template<typename Axis, typename Spacing>
+void
+CQToolStripLayoutT<Axis, Spacing>::
+updateSegments()
+{
+  auto &areas = strip_->areas_;
+
+  auto n = areas.size();
+
+  // compacted index of areas not hidden by user (needed for splitter lengths)
+  auto &active = strip_->activeInds_;
+
+  active.clear();
+
+  for (uint i = 0; i < n; ++i) {
+    areas[i]->index_ = int(i);
+
+    if (! areas[i]->isHiddenByUser())
+      active.push_back(int(i));
+  }
+
+  auto &geometry = strip_->geometry_;
+
+  geometry.reset(int(n), Spacing::gap);
+
+  for (uint i = 0; i < n; ++i)
+    updateGeometry(i);
+
+  strip_->lengths_.build(geometry.extents());
+
+  //---
+
+  for (auto *group : strip_->groups_) {
+    group->startInd_ = -1;
+    group->endInd_   = -1;
+  }
+
+  for (uint i = 0; i < n; ++i) {
+    auto *group = areas[i]->group();
+
+    if (! group) continue;
+
+    if (group->startInd_ < 0)
+      group->startInd_ = int(i);
+
+    group->endInd_ = int(i);
+  }
+
+  for (auto *group : strip_->groups_) {
+    if (group->startInd_ < 0)
+      group->hideButton();
+  }
+
+  strip_->segmentsValid_ = true;
+}
+
+template<typename Axis, typename Spacing>
+void
+CQToolStripLayoutT<Axis, Spacing>::
+updateSegment(int ind)
+{
+  updateGeometry(uint(ind));
+
+  strip_->lengths_.setValue(ind, strip_->geometry_.extent(ind));
+}
+
+// copy area state to geometry table
+template<typename Axis, typename Spacing>
+void
+CQToolStripLayoutT<Axis, Spacing>::
+updateGeometry(uint i)
+{
+  typedef CQToolStripGeometryTable Table;
+
+  auto *area = strip_->areas_[i];
+
+  unsigned int flags = Table::NoFlags;
+
+  if (area->isHiddenByUser()) flags |= Table::Hidden;
+  if (area->isResizable  ()) flags |= Table::Resizable;
+  if (area->nestedStrip  ()) flags |= Table::Nested;
+  if (area->group        ()) flags |= Table::Grouped;
+  if (area->isClipped    ()) flags |= Table::Clipped;
+
+  strip_->geometry_.setArea(int(i), area->displayWidth(), minLength(area),
+                            splitterLength(i), flags);
+}
+
+template<typename Axis, typename Spacing>
+void
+CQToolStripLayoutT<Axis, Spacing>::
+updateActiveArea(int ind)
+{
+  if (! strip_->segmentsValid_) {
+    updateSegments();
+    return;
+  }
+
+  auto &active = strip_->activeInds_;
+
+  auto p = std::lower_bound(active.begin(), active.end(), ind);
+
+  bool found = (p != active.end() && *p == ind);
+
+  if      (strip_->areas_[uint(ind)]->isHiddenByUser()) {
+    if (found)
+      active.erase(p);
+  }
+  else {
+    if (! found)
+      active.insert(p, ind);
+  }
+
+  updateSegment(ind);
+
+  // splitter of previous active area depends on it being last
+  p = std::lower_bound(active.begin(), active.end(), ind);
+
+  if (p != active.begin())
+    updateSegment(*(p - 1));
+}
+
+template<typename Axis, typename Spacing>
+void
+CQToolStripLayoutT<Axis, Spacing>::
+ensureSegments() const
+{
+  if (! strip_->segmentsValid_)
+    const_cast<CQToolStripLayoutT *>(this)->updateSegments();
+}
+
+template<typename Axis, typename Spacing>
+int
+CQToolStripLayoutT<Axis, Spacing>::
+splitterLength(uint i) const
+{
+  auto *area = strip_->areas_[i];
+
+  // no splitter after last active area
+  return (area->isResizable() && ! area->isHiddenByUser() && int(i) < lastActiveInd() ?
+          Spacing::splitter : 0);
+}
+
+template<typename Axis, typename Spacing>
+int
+CQToolStripLayoutT<Axis, Spacing>::
+lastActiveInd() const
+{
+  const auto &active = strip_->activeInds_;
+
+  return (! active.empty() ? active.back() : -1);
+}
+
+template<typename Axis, typename Spacing>
+int
+CQToolStripLayoutT<Axis, Spacing>::
+collapsedLength(CQToolStripGroup *group) const
+{
+  return Axis::length(group->button()->sizeHint()) + Spacing::gap;
+}
+
+template<typename Axis, typename Spacing>
+uint
+CQToolStripLayoutT<Axis, Spacing>::
+unitEnd(uint i) const
+{
+  const auto &areas = strip_->areas_;
+
+  auto *group = areas[i]->group();
+
+  if (! group)
+    return i;
+
+  auto n = areas.size();
+
+  while (i + 1 < n && areas[i + 1]->group() == group)
+    ++i;
+
+  return i;
+}
+
+template<typename Axis, typename Spacing>
+int
+CQToolStripLayoutT<Axis, Spacing>::
+contentsLength() const
+{
+  ensureSegments();
+
+  const auto &lengths = strip_->lengths_;
+
+  int len = Spacing::margin + lengths.total();
+
+  // replace collapsed group areas by group button
+  for (auto *group : strip_->groups_) {
+    if (group->startInd_ < 0 || ! group->isShownCollapsed())
+      continue;
+
+    len += collapsedLength(group) - lengths.sum(group->startInd_, group->endInd_);
+  }
+
+  return len;
+}
+
+template<typename Axis, typename Spacing>
+void
+CQToolStripLayoutT<Axis, Spacing>::
+splitterMoved(int ind, int d)
+{
+  auto &areas = strip_->areas_;
+
+  int length = stripLength();
+
+  // wrapped area only limited by row length (following areas wrap)
+  if (strip_->overflowPolicy() == CQToolStrip::OverflowWrap) {
+    auto *area = areas[uint(ind)];
+
+    int len = std::max(std::min(area->displayWidth() + d, length - 2*Spacing::margin),
+                       minLength(area));
+
+    area->setDisplayWidth(len);
+
+    updateLayout();
+
+    return;
+  }
+
+  int fitLen = contentsLength();
+
+  auto *area = areas[uint(ind)];
+
+  int minAreaLen = minLength(area);
+  int maxAreaLen = length - Axis::length(minimumSizeHint());
+
+  int len = std::min(std::max(area->displayWidth() + d, minAreaLen), maxAreaLen);
+
+  d = len - area->displayWidth();
+
+  if (d > 0) {
+    // calc length
+    int cl = contentsLength() + d;
+
+    int dl = cl - length;
+
+    if (dl > 0) {
+      // shrink others
+      auto n = areas.size();
+
+      for (int i = ind + 1; i < int(n); ++i) {
+        auto *area1 = areas[uint(i)];
+
+        if (splitterLength(uint(i)) == 0) continue;
+
+        int len1    = area1->displayWidth();
+        int minLen1 = minLength(area1);
+
+        if (len1 > minLen1) {
+          len1 -= dl;
+
+          int newLen1 = std::max(len1 - dl, minLen1);
+
+          dl -= len1 - newLen1;
+
+          if (newLen1 != len1)
+            area1->setLayoutWidth(newLen1);
+        }
+      }
+    }
+
+    //---
+
+    int maxLen = length - contentsLength() + area->displayWidth();
+
+    if (len > maxLen) len = maxLen;
+
+    area->setDisplayWidth(len);
+
+    //---
+
+    expandToFit(ind, fitLen);
+  }
+  else {
+    int minLen = minLength(area);
+
+    if (len < minLen) len = minLen;
+
+    area->setDisplayWidth(len);
+
+    //---
+
+    expandToFit(ind, fitLen);
+  }
+
+  updateLayout();
+}
+
+template<typename Axis, typename Spacing>
+void
+CQToolStripLayoutT<Axis, Spacing>::
+expandToFit(int stopInd, int fitLen)
+{
+  auto &areas = strip_->areas_;
+
+  if (fitLen < 0)
+    fitLen = contentsLength();
+
+  auto n = areas.size();
+
+  for (int i = int(n - 2); i >= 0; --i) {
+    if (i == stopInd) break;
+
+    auto *area1 = areas[uint(i)];
+
+    if (splitterLength(uint(i)) == 0) continue;
+
+    int dl = fitLen - contentsLength();
+
+    int len1 = area1->displayWidth() + dl;
+
+    int minLen1 = minLength(area1);
+
+    if (len1 < minLen1) len1 = minLen1;
+
+    area1->setLayoutWidth(len1);
+
+    return;
+  }
+}
+
+template<typename Axis, typename Spacing>
+QSize
+CQToolStripLayoutT<Axis, Spacing>::
+sizeHint() const
+{
+  const auto &areas = strip_->areas_;
+
+  ensureSegments();
+
+  int l = Spacing::margin, b = 0;
+
+  auto n = areas.size();
+
+  for (uint i = 0; i < n; ++i) {
+    const auto *area = areas[i];
+
+    // collapsed group is just group button
+    auto *group = area->group();
+
+    if (group && group->isCollapsed()) {
+      if (i == 0 || areas[i - 1]->group() != group)
+        l += collapsedLength(group);
+    }
+
+    if (area->isHiddenByUser()) continue;
+
+    b = std::max(b, Axis::breadth(area->sizeHint()));
+
+    if (group && group->isCollapsed()) continue;
+
+    l += minLength(area) + Spacing::gap + splitterLength(i);
+  }
+
+  // wrapped rows at current length
+  if (strip_->overflowPolicy() == CQToolStrip::OverflowWrap)
+    b = std::max(b, strip_->wrapBreadth_);
+
+  return Axis::size(l, b);
+}
+
+template<typename Axis, typename Spacing>
+CQToolStripLayoutInput
+CQToolStripLayoutT<Axis, Spacing>::
+snapshot() const
+{
+  const auto &areas  = strip_->areas_;
+  const auto &groups = strip_->groups_;
+
+  CQToolStripLayoutInput input;
+
+  input.scroll           = (strip_->overflowPolicy() == CQToolStrip::OverflowScroll);
+  input.stripLength      = stripLength();
+  input.menuButtonLength = Axis::length(strip_->menuButton_->size());
+  input.margin           = Spacing::margin;
+  input.gap              = Spacing::gap;
+  input.splitter         = Spacing::splitter;
+
+  std::map<CQToolStripGroup *, int> groupInd;
+
+  input.groups.resize(groups.size());
+
+  for (uint i = 0; i < groups.size(); ++i) {
+    auto *group = groups[i];
+
+    groupInd[group] = int(i);
+
+    input.groups[i].collapsed    = group->isCollapsed();
+    input.groups[i].buttonLength = Axis::length(group->button()->sizeHint());
+  }
+
+  // area metrics from geometry table (only changed areas are measured)
+  ensureSegments();
+
+  typedef CQToolStripGeometryTable Table;
+
+  const auto &geometry = strip_->geometry_;
+
+  auto n = areas.size();
+
+  input.areas.resize(n);
+
+  for (uint i = 0; i < n; ++i) {
+    auto &iarea = input.areas[i];
+
+    unsigned int flags = geometry.flags(int(i));
+
+    iarea.area      = areas[i];
+    iarea.length    = geometry.length   (int(i));
+    iarea.minLength = geometry.minLength(int(i));
+    iarea.resizable = (flags & Table::Resizable);
+    iarea.hidden    = (flags & Table::Hidden);
+    iarea.nested    = (flags & Table::Nested);
+    iarea.group     = ((flags & Table::Grouped) ? groupInd[areas[i]->group()] : -1);
+  }
+
+  return input;
+}
+
+template<typename Axis, typename Spacing>
+void
+CQToolStripLayoutT<Axis, Spacing>::
+applyResult(const CQToolStripLayoutResult &result)
+{
+  applyState(result);
+
+  auto n = strip_->areas_.size();
+
+  for (uint i = 0; i < n; ++i)
+    applyArea(result, i);
+
+  applyControls(result);
+}
+
+template<typename Axis, typename Spacing>
+void
+CQToolStripLayoutT<Axis, Spacing>::
+applyState(const CQToolStripLayoutResult &result)
+{
+  auto &areas  = strip_->areas_;
+  auto &groups = strip_->groups_;
+
+  auto n = areas.size();
+
+  for (uint i = 0; i < n; ++i) {
+    auto *area  = areas[i];
+    auto &rarea = result.areas[i];
+
+    if (rarea.lengthChanged)
+      area->setLayoutWidth(rarea.length);
+
+    area->setClipped(rarea.clipped);
+  }
+
+  for (uint i = 0; i < groups.size(); ++i)
+    groups[i]->autoCollapsed_ = result.groups[i].autoCollapsed;
+
+  strip_->clip_ = result.clip;
+
+  updateScrollButtons();
+}
+
+template<typename Axis, typename Spacing>
+void
+CQToolStripLayoutT<Axis, Spacing>::
+applyArea(const CQToolStripLayoutResult &result, uint i)
+{
+  auto *area  = strip_->areas_[i];
+  auto &rarea = result.areas[i];
+
+  // clipped area in open menu
+  if (area->parentWidget() != strip_)
+    return;
+
+  if (area->isHidden() == rarea.visible)
+    area->setVisible(rarea.visible);
+
+  if (! rarea.visible)
+    return;
+
+  QRect rect(Axis::point(rarea.pos - scrollOffset(), 0),
+             Axis::size(rarea.length, stripBreadth()));
+
+  if (area->geometry() != rect)
+    area->setGeometry(rect);
+  else
+    area->updateLayout();
+}
+
+template<typename Axis, typename Spacing>
+void
+CQToolStripLayoutT<Axis, Spacing>::
+applyControls(const CQToolStripLayoutResult &result)
+{
+  auto &groups = strip_->groups_;
+
+  int breadth = stripBreadth();
+
+  int offset = scrollOffset();
+
+  for (uint i = 0; i < groups.size(); ++i) {
+    auto *group  = groups[i];
+    auto &rgroup = result.groups[i];
+
+    if (! rgroup.buttonShown) {
+      group->hideButton();
+      continue;
+    }
+
+    auto *button = group->button();
+
+    int len = Axis::length(button->sizeHint());
+
+    button->setGeometry(QRect(Axis::point(rgroup.buttonPos - offset, 0),
+                              Axis::size(len, breadth)));
+
+    button->show();
+    button->raise();
+  }
+
+  //---
+
+  strip_->hideSplitters();
+
+  for (const auto &rsplitter : result.splitters) {
+    CQToolStripSplitter *splitter = strip_->getSplitter();
+
+    splitter->init(rsplitter.ind, Axis::splitterOrient);
+
+    splitter->move  (Axis::point(rsplitter.pos - offset - Spacing::splitterOffset, 0));
+    splitter->resize(Axis::size(Spacing::splitter, breadth));
+
+    splitter->show();
+
+    QObject::connect(splitter, SIGNAL(splitterMoved(int, int)),
+                     strip_, SLOT(splitterMoved(int, int)), Qt::UniqueConnection);
+  }
+
+  //---
+
+  auto *menuButton = strip_->menuButton_;
+
+  menuButton->setVisible(result.clip);
+
+  if (result.clip) {
+    QSize bs = menuButton->size();
+
+    menuButton->move(Axis::point(stripLength() - Axis::length(bs),
+                                 (stripBreadth() - Axis::breadth(bs))/2));
+
+    menuButton->raise();
+  }
+}
+
+template<typename Axis, typename Spacing>
+int
+CQToolStripLayoutT<Axis, Spacing>::
+scrollOffset() const
+{
+  if (strip_->scrollRange_ <= 0)
+    return 0;
+
+  // first area starts after back button when not scrolled
+  return strip_->scrollPos_ - Axis::length(strip_->menuButton_->size());
+}
+
+template<typename Axis, typename Spacing>
+void
+CQToolStripLayoutT<Axis, Spacing>::
+updateScrollButtons()
+{
+  auto *backButton    = strip_->scrollBackButton_;
+  auto *forwardButton = strip_->scrollForwardButton_;
+
+  if (strip_->overflowPolicy() != CQToolStrip::OverflowScroll) {
+    strip_->scrollRange_ = 0;
+    strip_->scrollPos_   = 0;
+
+    if (backButton) {
+      backButton   ->hide();
+      forwardButton->hide();
+    }
+
+    return;
+  }
+
+  // scroll so all areas can be seen between scroll buttons
+  int len       = contentsLength();
+  int buttonLen = Axis::length(strip_->menuButton_->size());
+
+  int range = (len > stripLength() ? len + 2*buttonLen - stripLength() : 0);
+
+  strip_->scrollRange_ = range;
+  strip_->scrollPos_   = std::min(std::max(strip_->scrollPos_, 0), range);
+
+  backButton   ->setArrowType(Axis::backArrow);
+  forwardButton->setArrowType(Axis::forwardArrow);
+
+  backButton   ->setVisible(range > 0);
+  forwardButton->setVisible(range > 0);
+
+  placeScrollButtons();
+}
+
+template<typename Axis, typename Spacing>
+void
+CQToolStripLayoutT<Axis, Spacing>::
+placeScrollButtons()
+{
+  if (strip_->scrollRange_ <= 0)
+    return;
+
+  auto *backButton    = strip_->scrollBackButton_;
+  auto *forwardButton = strip_->scrollForwardButton_;
+
+  int buttonLen = Axis::length(strip_->menuButton_->size());
+
+  backButton   ->setGeometry(QRect(Axis::point(0, 0), Axis::size(buttonLen, stripBreadth())));
+  forwardButton->setGeometry(QRect(Axis::point(stripLength() - buttonLen, 0),
+                                   Axis::size(buttonLen, stripBreadth())));
+
+  backButton   ->setEnabled(strip_->scrollPos_ > 0);
+  forwardButton->setEnabled(strip_->scrollPos_ < strip_->scrollRange_);
+
+  backButton   ->raise();
+  forwardButton->raise();
+}
+
+template<typename Axis, typename Spacing>
+int
+CQToolStripLayoutT<Axis, Spacing>::
+unitLength(uint i) const
+{
+  auto *group = strip_->areas_[i]->group();
+
+  // groups are only collapsed by user when wrapped
+  if (group && group->isCollapsed())
+    return collapsedLength(group);
+
+  return strip_->lengths_.sum(int(i), int(unitEnd(i)));
+}
+
+template<typename Axis, typename Spacing>
+void
+CQToolStripLayoutT<Axis, Spacing>::
+updateWrapLayout()
+{
+  auto &areas = strip_->areas_;
+  auto &rows  = strip_->rows_;
+
+  strip_->menuButton_->hide();
+
+  strip_->clip_ = false;
+
+  updateScrollButtons();
+
+  for (auto *group : strip_->groups_)
+    group->autoCollapsed_ = false;
+
+  // rows before first changed row are already placed
+  uint start = uint(breakRows(stripLength(), rows));
+
+  int breadth = rowsBreadth(rows);
+
+  if (breadth != strip_->wrapBreadth_) {
+    strip_->wrapBreadth_ = breadth;
+
+    // parent notified (once) when size hint changes
+    strip_->invalidateSizeHintCache();
+  }
+
+  if (start >= rows.size())
+    return;
+
+  //---
+
+  int offset = 0;
+
+  for (uint r = 0; r < start; ++r)
+    offset += rows[r].breadth + Spacing::gap;
+
+  int oldSplitterPos = strip_->splitterPos_;
+
+  strip_->splitterPos_ = 0;
+
+  for (uint i = 0; i < uint(rows[start].start); ++i) {
+    auto *group = areas[i]->group();
+
+    if (splitterLength(i) > 0 && ! (group && group->isCollapsed()))
+      ++strip_->splitterPos_;
+  }
+
+  for (uint r = start; r < rows.size(); ++r) {
+    const auto &row = rows[r];
+
+    rowOffset_  = offset;
+    rowBreadth_ = row.breadth;
+
+    int pos = Spacing::margin;
+
+    for (uint i = uint(row.start); i <= uint(row.end); ) {
+      uint j = unitEnd(i);
+
+      auto *group = areas[i]->group();
+
+      bool collapsed = (group && group->isCollapsed());
+
+      for (uint k = i; k <= j; ++k) {
+        auto *area = areas[k];
+
+        area->rowLabelHeight_ = row.labelHeight;
+
+        area->setClipped(false);
+        area->setVisible(! collapsed && ! area->isHiddenByUser());
+      }
+
+      if (collapsed)
+        placeGroupButton(group, pos);
+      else {
+        if (group)
+          group->hideButton();
+
+        for (uint k = i; k <= j; ++k)
+          placeArea(k, pos);
+      }
+
+      i = j + 1;
+    }
+
+    offset += row.breadth + Spacing::gap;
+  }
+
+  rowOffset_  = 0;
+  rowBreadth_ = -1;
+
+  for (int i = strip_->splitterPos_; i < oldSplitterPos; ++i)
+    strip_->splitters_[uint(i)]->hide();
+}
+
+// greedy line break of areas into rows of length. Leading rows which break the same
+// at the new length are kept (return index of first new row)
+template<typename Axis, typename Spacing>
+int
+CQToolStripLayoutT<Axis, Spacing>::
+breakRows(int length, CQToolStrip::Rows &rows) const
+{
+  ensureSegments();
+
+  auto n = strip_->areas_.size();
+
+  // row changes if it no longer fits or next unit now fits
+  uint keep = 0;
+
+  for ( ; keep < rows.size(); ++keep) {
+    const auto &row = rows[keep];
+
+    if (row.length - splitterLength(uint(row.end)) > length)
+      break;
+
+    uint next = uint(row.end + 1);
+
+    if (next < n && row.length + unitLength(next) - splitterLength(unitEnd(next)) <= length)
+      break;
+  }
+
+  rows.resize(keep);
+
+  uint i = (keep > 0 ? uint(rows.back().end + 1) : 0);
+
+  while (i < n) {
+    CQToolStrip::Row row;
+
+    row.start  = int(i);
+    row.length = Spacing::margin;
+
+    while (i < n) {
+      uint j = unitEnd(i);
+
+      int len = unitLength(i);
+
+      // row has at least one unit (following splitter can be clipped)
+      if (row.end >= row.start && row.length + len - splitterLength(j) > length)
+        break;
+
+      row.length += len;
+      row.end     = int(j);
+
+      i = j + 1;
+    }
+
+    updateRowBreadth(row);
+
+    rows.push_back(row);
+  }
+
+  return int(keep);
+}
+
+template<typename Axis, typename Spacing>
+void
+CQToolStripLayoutT<Axis, Spacing>::
+updateRowBreadth(CQToolStrip::Row &row) const
+{
+  const auto &areas = strip_->areas_;
+
+  // labels only aligned across areas of horizontal strip
+  bool alignLabels = (strip_->orientation() == Qt::Horizontal);
+
+  row.labelHeight = 0;
+  row.breadth     = 0;
+
+  for (int i = row.start; i <= row.end; ++i) {
+    auto *group = areas[uint(i)]->group();
+
+    if (areas[uint(i)]->isHiddenByUser()) continue;
+
+    if (! group || ! group->isCollapsed())
+      row.labelHeight = std::max(row.labelHeight, areas[uint(i)]->labelMinHeight());
+  }
+
+  for (int i = row.start; i <= row.end; ++i) {
+    auto *area  = areas[uint(i)];
+    auto *group = area->group();
+
+    if (area->isHiddenByUser() && ! (group && group->isCollapsed())) continue;
+
+    QSize s;
+
+    if (group && group->isCollapsed())
+      s = group->button()->sizeHint();
+    else
+      s = area->calcSizeHint(alignLabels ? row.labelHeight : area->labelMinHeight());
+
+    row.breadth = std::max(row.breadth, Axis::breadth(s));
+  }
+}
+
+template<typename Axis, typename Spacing>
+int
+CQToolStripLayoutT<Axis, Spacing>::
+rowsBreadth(const CQToolStrip::Rows &rows)
+{
+  int breadth = 0;
+
+  for (const auto &row : rows)
+    breadth += row.breadth;
+
+  if (! rows.empty())
+    breadth += int(rows.size() - 1)*Spacing::gap;
+
+  return breadth;
+}
+
+template<typename Axis, typename Spacing>
+int
+CQToolStripLayoutT<Axis, Spacing>::
+wrapBreadth(int length) const
+{
+  CQToolStrip::Rows rows;
+
+  breakRows(length, rows);
+
+  return rowsBreadth(rows);
+}
+
+template<typename Axis, typename Spacing>
+QSize
+CQToolStripLayoutT<Axis, Spacing>::
+minimumSizeHint() const
+{
+  const auto &areas = strip_->areas_;
+
+  int b = 0;
+
+  for (const auto *area : areas) {
+    if (area->isHiddenByUser()) continue;
+
+    b = std::max(b, Axis::breadth(area->minimumSizeHint()));
+  }
+
+  return Axis::size(Spacing::minLength, b);
+}
+
+#endif
@@ -0,0 +1,301 @@
+#include <CQToolStripLayoutSolver.h>
+#include <algorithm>
+
+// full layout for all overflow policies except wrap (see CQToolStrip::updateLayout)
+CQToolStripLayoutResult
+CQToolStripLayoutSolver::
+solve(const CQToolStripLayoutInput &input)
+{
+  CQToolStripLayoutSolver solver(input);
+
+  int visInd = -1;
+
+  if (! input.restored) {
+    solver.reduceSize();
+
+    // nothing clipped if scrolled
+    visInd = (! input.scroll ? solver.clipUnits(0) : -1);
+
+    // make room for menu button
+    if (visInd >= 0)
+      visInd = solver.clipUnits(input.menuButtonLength);
+  }
+  else
+    visInd = input.clipInd;
+
+  auto &result = solver.result_;
+
+  for (int i = 0; i < solver.n_; ++i) {
+    auto &area = result.areas[uint(i)];
+
+    const auto &iarea = input.areas[uint(i)];
+
+    area.clipped = (visInd >= 0 && i >= visInd && ! iarea.hidden);
+    area.visible = (! area.clipped && ! solver.isCollapsed(iarea.group) && ! iarea.hidden);
+  }
+
+  result.clip = (visInd >= 0);
+
+  solver.place();
+
+  return result;
+}
+
+CQToolStripLayoutSolver::
+CQToolStripLayoutSolver(const CQToolStripLayoutInput &input) :
+ input_(input), n_(int(input.areas.size())), last_(-1), grouped_(false)
+{
+  result_.generation = input_.generation;
+
+  result_.areas .resize(input_.areas .size());
+  result_.groups.resize(input_.groups.size());
+
+  for (int i = 0; i < n_; ++i) {
+    const auto &area = input_.areas[uint(i)];
+
+    result_.areas[uint(i)].length = area.length;
+
+    if (! area.hidden)
+      last_ = i;
+
+    if (area.group >= 0)
+      grouped_ = true;
+  }
+}
+
+// shrink resizable areas (last first) as much as possible if too small
+void
+CQToolStripLayoutSolver::
+reduceSize()
+{
+  int d = contentsLength() - input_.stripLength;
+
+  for (int i = n_ - 1; i >= 0 && d > 0; --i) {
+    const auto &area = input_.areas[uint(i)];
+
+    int group = area.group;
+
+    if (group >= 0 && input_.groups[uint(group)].collapsed)
+      continue;
+
+    if (area.hidden || ! (splitterLength(i) > 0 || area.nested))
+      continue;
+
+    auto &rarea = result_.areas[uint(i)];
+
+    if (rarea.length > area.minLength) {
+      int newLen = std::max(rarea.length - d, area.minLength);
+
+      d -= rarea.length - newLen;
+
+      rarea.length        = newLen;
+      rarea.lengthChanged = true;
+    }
+  }
+
+  if (! grouped_)
+    updateGeometry();
+}
+
+// copy (shrunk) area lengths to geometry table for clip scan
+void
+CQToolStripLayoutSolver::
+updateGeometry()
+{
+  geometry_.reset(n_, input_.gap);
+
+  for (int i = 0; i < n_; ++i) {
+    const auto &area = input_.areas[uint(i)];
+
+    geometry_.setArea(i, result_.areas[uint(i)].length, area.minLength, splitterLength(i),
+                      area.hidden ? CQToolStripGeometryTable::Hidden :
+                                    CQToolStripGeometryTable::NoFlags);
+  }
+}
+
+// get index of first area (unit) which doesn't fit (-1 if all fit)
+int
+CQToolStripLayoutSolver::
+clipUnits(int reserve)
+{
+  int length = input_.stripLength - reserve;
+
+  // without groups first clipped unit is first area which ends after strip
+  // (following splitter can be clipped)
+  if (! grouped_) {
+    int i = geometry_.firstExceeding(length - input_.margin);
+
+    return (i < n_ ? i : -1);
+  }
+
+  int pos = input_.margin;
+
+  for (int i = 0; i < n_; ) {
+    int j = unitEnd(i);
+
+    int group = input_.areas[uint(i)].group;
+
+    bool userCollapsed = (group >= 0 && input_.groups[uint(group)].collapsed);
+
+    if (group >= 0)
+      result_.groups[uint(group)].autoCollapsed = false;
+
+    // area must fit (following splitter can be clipped)
+    int len = 0, splitterLen = 0;
+
+    if (userCollapsed)
+      len = collapsedLength(group);
+    else {
+      for (int k = i; k <= j; ++k)
+        len += areaLength(k);
+
+      splitterLen = splitterLength(j);
+    }
+
+    if (pos + len - splitterLen > length) {
+      // collapse group to fit
+      if (group >= 0 && ! userCollapsed) {
+        int clen = collapsedLength(group);
+
+        if (pos + clen <= length) {
+          result_.groups[uint(group)].autoCollapsed = true;
+
+          pos += clen;
+
+          i = j + 1;
+
+          continue;
+        }
+      }
+
+      return i;
+    }
+
+    pos += len;
+
+    i = j + 1;
+  }
+
+  return -1;
+}
+
+// place areas, splitters and buttons of collapsed groups
+void
+CQToolStripLayoutSolver::
+place()
+{
+  int pos = input_.margin;
+
+  for (int i = 0; i < n_; ) {
+    int j = unitEnd(i);
+
+    int group = input_.areas[uint(i)].group;
+
+    if (isCollapsed(group) && ! result_.areas[uint(i)].clipped) {
+      auto &rgroup = result_.groups[uint(group)];
+
+      rgroup.buttonShown = true;
+      rgroup.buttonPos   = pos;
+
+      pos += collapsedLength(group);
+
+      i = j + 1;
+
+      continue;
+    }
+
+    for (int k = i; k <= j; ++k) {
+      if (input_.areas[uint(k)].hidden) continue;
+
+      auto &rarea = result_.areas[uint(k)];
+
+      rarea.pos = pos;
+
+      pos += rarea.length + input_.gap;
+
+      if (splitterLength(k) > 0) {
+        result_.splitters.push_back(CQToolStripLayoutResult::Splitter(k, pos));
+
+        pos += input_.splitter;
+      }
+    }
+
+    i = j + 1;
+  }
+}
+
+int
+CQToolStripLayoutSolver::
+unitEnd(int i) const
+{
+  int group = input_.areas[uint(i)].group;
+
+  if (group < 0)
+    return i;
+
+  while (i + 1 < n_ && input_.areas[uint(i + 1)].group == group)
+    ++i;
+
+  return i;
+}
+
+int
+CQToolStripLayoutSolver::
+areaLength(int i) const
+{
+  if (input_.areas[uint(i)].hidden)
+    return 0;
+
+  return result_.areas[uint(i)].length + input_.gap + splitterLength(i);
+}
+
+int
+CQToolStripLayoutSolver::
+splitterLength(int i) const
+{
+  const auto &area = input_.areas[uint(i)];
+
+  // no splitter after last area which isn't hidden
+  return (area.resizable && ! area.hidden && i < last_ ? input_.splitter : 0);
+}
+
+int
+CQToolStripLayoutSolver::
+collapsedLength(int group) const
+{
+  return input_.groups[uint(group)].buttonLength + input_.gap;
+}
+
+bool
+CQToolStripLayoutSolver::
+isCollapsed(int group) const
+{
+  if (group < 0)
+    return false;
+
+  return (input_.groups[uint(group)].collapsed || result_.groups[uint(group)].autoCollapsed);
+}
+
+int
+CQToolStripLayoutSolver::
+contentsLength() const
+{
+  int len = input_.margin;
+
+  for (int i = 0; i < n_; ) {
+    int j = unitEnd(i);
+
+    int group = input_.areas[uint(i)].group;
+
+    if (isCollapsed(group))
+      len += collapsedLength(group);
+    else {
+      for (int k = i; k <= j; ++k)
+        len += areaLength(k);
+    }
+
+    i = j + 1;
+  }
+
+  return len;
+}
@@ -0,0 +1,144 @@
+#ifndef CQToolStripLayoutSolver_H
+#define CQToolStripLayoutSolver_H
+
+/*!
+ * Widget free layout solve for CQToolStrip.
+ *
+ * The strip snapshots its area metrics into a CQToolStripLayoutInput on the GUI thread,
+ * the solve (shrink resizable areas, collapse/clip groups and areas, place areas and
+ * splitters) runs on the GUI thread (sync layout) or a worker thread (async layout) and
+ * the GUI thread applies the result. Results are tagged with the generation of the
+ * request so stale results can be discarded.
+ *
+ * All lengths are along the strip (x for horizontal, y for vertical).
+ */
+
+#include <CQToolStripGeometryTable.h>
+#include <vector>
+
+class CQToolStripArea;
+
+struct CQToolStripLayoutInput {
+  struct Area {
+    CQToolStripArea *area;      // GUI side only (not accessed by solver)
+    int              length;    // current display length
+    int              minLength;
+    bool             resizable;
+    bool             nested;
+    bool             hidden;    // hidden by user (skipped)
+    int              group;     // group index (-1 if none)
+
+    Area() :
+     area(0), length(0), minLength(0), resizable(false), nested(false), hidden(false),
+     group(-1) {
+    }
+  };
+
+  struct Group {
+    bool collapsed;    // collapsed by user
+    int  buttonLength; // length of collapsed group button
+
+    Group() :
+     collapsed(false), buttonLength(0) {
+    }
+  };
+
+  int                generation;
+  bool               scroll;      // scroll overflow policy (no clipping)
+  bool               restored;    // use restored clip index (no shrink or clip solve)
+  int                clipInd;     // restored first clipped area (-1 if none)
+  int                stripLength;
+  int                menuButtonLength;
+  int                margin;
+  int                gap;
+  int                splitter;
+  std::vector<Area>  areas;
+  std::vector<Group> groups;
+
+  CQToolStripLayoutInput() :
+   generation(0), scroll(false), restored(false), clipInd(-1), stripLength(0),
+   menuButtonLength(0), margin(0), gap(0), splitter(0) {
+  }
+};
+
+struct CQToolStripLayoutResult {
+  struct Area {
+    int  pos;
+    int  length;
+    bool lengthChanged; // shrunk to fit
+    bool clipped;
+    bool visible;
+
+    Area() :
+     pos(0), length(0), lengthChanged(false), clipped(false), visible(true) {
+    }
+  };
+
+  struct Splitter {
+    int ind; // index of area before splitter
+    int pos;
+
+    Splitter(int ind=-1, int pos=0) :
+     ind(ind), pos(pos) {
+    }
+  };
+
+  struct Group {
+    bool autoCollapsed; // collapsed to fit
+    bool buttonShown;
+    int  buttonPos;
+
+    Group() :
+     autoCollapsed(false), buttonShown(false), buttonPos(0) {
+    }
+  };
+
+  int                   generation;
+  bool                  clip;
+  std::vector<Area>     areas;
+  std::vector<Splitter> splitters;
+  std::vector<Group>    groups;
+
+  CQToolStripLayoutResult() :
+   generation(0), clip(false) {
+  }
+};
+
+class CQToolStripLayoutSolver {
+ public:
+  //! solve layout (safe to call from any thread)
+  static CQToolStripLayoutResult solve(const CQToolStripLayoutInput &input);
+
+ private:
+  explicit CQToolStripLayoutSolver(const CQToolStripLayoutInput &input);
+
+  void reduceSize();
+
+  int clipUnits(int reserve);
+
+  int unitEnd(int i) const;
+
+  int areaLength(int i) const;
+
+  int splitterLength(int i) const;
+
+  int collapsedLength(int group) const;
+
+  bool isCollapsed(int group) const;
+
+  int contentsLength() const;
+
+  void place();
+
+  void updateGeometry();
+
+ private:
+  const CQToolStripLayoutInput &input_;
+  CQToolStripLayoutResult       result_;
+  int                           n_;
+  int                           last_;     // last area not hidden (-1 if none)
+  bool                          grouped_;  // any area in group
+  CQToolStripGeometryTable      geometry_; // area extents (ungrouped clip)
+};
+
+#endif
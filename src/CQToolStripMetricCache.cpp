@@ -0,0 +1,568 @@
+#include <CQToolStripMetricCache.h>
+#include <CQToolStripMemory.h>
+#include <CQWidgetUtil.h>
+#include <QToolButton>
+#include <QPushButton>
+#include <QCheckBox>
+#include <QLineEdit>
+#include <QLabel>
+#include <QStyle>
+#include <QApplication>
+#include <QScreen>
+#include <QFile>
+#include <QSaveFile>
+#include <QTimer>
+#include <algorithm>
+
+// persistent file header (entries follow header)
+static const quint32 fileMagic   = 0x4351544d; // 'CQTM'
+static const quint32 fileVersion = 1;
+
+// bump when widget keys or measurement change (invalidates saved files)
+static const int metricVersion = 1;
+
+// prefix of area label keys (measured by minimum size hint)
+static const char *labelPrefix = "label|";
+
+namespace {
+
+struct FileHeader {
+  quint32 magic;
+  quint32 version;
+  quint64 envHash;
+  quint32 numEntries;
+  quint32 reserved;
+};
+
+}
+
+struct CQToolStripMetricCache::FileEntry {
+  quint64 key;
+  qint32  minWidth, minHeight;
+  qint32  hintWidth, hintHeight;
+};
+
+CQToolStripMetricCache *
+CQToolStripMetricCache::
+instance()
+{
+  static CQToolStripMetricCache *instance;
+
+  if (! instance)
+    instance = new CQToolStripMetricCache;
+
+  return instance;
+}
+
+CQToolStripMetricCache::
+CQToolStripMetricCache() :
+ enabled_(false), maxSize_(2048), useCount_(0), numHits_(0), numMisses_(0), file_(0),
+ fileEntries_(0), numFileEntries_(0), numFileHits_(0), verifyTimer_(0)
+{
+}
+
+void
+CQToolStripMetricCache::
+setEnabled(bool enabled)
+{
+  enabled_ = enabled;
+
+  if (! enabled_)
+    clear();
+}
+
+void
+CQToolStripMetricCache::
+setMaxSize(int n)
+{
+  maxSize_ = std::max(n, 1);
+
+  if (size() > maxSize_)
+    trim(maxSize_);
+}
+
+QString
+CQToolStripMetricCache::
+widgetKey(const QWidget *w) const
+{
+  if (! w) return QString();
+
+  // style sheets can change size of any widget
+  QStyle *style = w->style();
+
+  if (style->inherits("QStyleSheetStyle"))
+    return QString();
+
+  // contents signature for exact widget classes which don't override size hints
+  QString className = w->metaObject()->className();
+
+  QString contents;
+
+  if      (className == "QToolButton") {
+    auto *button = static_cast<const QToolButton *>(w);
+
+    QSize is = button->iconSize();
+
+    contents = button->text() + "|" +
+               QString("%1x%2|%3|%4|%5|%6|%7").
+                 arg(is.width()).arg(is.height()).arg(button->icon().isNull() ? 0 : 1).
+                 arg(int(button->toolButtonStyle())).arg(int(button->popupMode())).
+                 arg(int(button->arrowType())).arg(button->menu() ? 1 : 0);
+  }
+  else if (className == "QPushButton" || className == "QCheckBox") {
+    auto *button = static_cast<const QAbstractButton *>(w);
+
+    QSize is = button->iconSize();
+
+    contents = button->text() + "|" +
+               QString("%1x%2|%3").
+                 arg(is.width()).arg(is.height()).arg(button->icon().isNull() ? 0 : 1);
+
+    if (className == "QPushButton" && static_cast<const QPushButton *>(w)->menu())
+      contents += "|menu";
+  }
+  else if (className == "QLineEdit") {
+    // line edit size doesn't depend on text
+    auto *edit = static_cast<const QLineEdit *>(w);
+
+    contents = QString("%1|%2").arg(edit->hasFrame() ? 1 : 0).
+                 arg(edit->isClearButtonEnabled() ? 1 : 0);
+  }
+  else
+    return QString();
+
+  // explicit size constraints
+  QSize minSize = w->minimumSize();
+  QSize maxSize = w->maximumSize();
+
+  QString constraints = QString("%1x%2|%3x%4").
+    arg(minSize.width()).arg(minSize.height()).arg(maxSize.width()).arg(maxSize.height());
+
+  return className + "|" + w->font().key() + "|" + style->metaObject()->className() + "|" +
+         QString::number(w->devicePixelRatioF()) + "|" + constraints + "|" + contents;
+}
+
+QString
+CQToolStripMetricCache::
+labelKey(const QLabel *label) const
+{
+  if (! label) return QString();
+
+  QStyle *style = label->style();
+
+  if (style->inherits("QStyleSheetStyle"))
+    return QString();
+
+  QString env = label->font().key() + "|" + style->metaObject()->className() + "|" +
+                QString::number(label->devicePixelRatioF());
+
+  QString format = QString("%1|%2|%3|%4").arg(int(label->textFormat())).
+                     arg(label->wordWrap() ? 1 : 0).arg(label->margin()).arg(label->indent());
+
+  return labelPrefix + env + "|" + format + "|" + label->text();
+}
+
+bool
+CQToolStripMetricCache::
+lookup(const QString &key, Metrics &metrics) const
+{
+  auto p = metrics_.find(key);
+
+  if (p == metrics_.end())
+    return false;
+
+  (*p).second.used = ++useCount_;
+
+  metrics = (*p).second.metrics;
+
+  return true;
+}
+
+void
+CQToolStripMetricCache::
+insert(const QString &key, const Metrics &metrics)
+{
+  // make room for new key (trim to half so trimming is infrequent)
+  if (size() >= maxSize_ && metrics_.find(key) == metrics_.end())
+    trim(maxSize_/2);
+
+  Entry &entry = metrics_[key];
+
+  entry.metrics = metrics;
+  entry.used    = ++useCount_;
+}
+
+// remove least recently used entries so at most n remain
+void
+CQToolStripMetricCache::
+trim(int n)
+{
+  if (size() <= n)
+    return;
+
+  std::vector<quint64> used;
+
+  for (const auto &p : metrics_)
+    used.push_back(p.second.used);
+
+  // entries used at or before threshold are removed
+  auto nr = used.size() - uint(std::max(n, 0));
+
+  std::nth_element(used.begin(), used.begin() + long(nr - 1), used.end());
+
+  quint64 threshold = used[nr - 1];
+
+  for (auto p = metrics_.begin(); p != metrics_.end(); ) {
+    if ((*p).second.used <= threshold) {
+      unverified_.erase((*p).first);
+
+      p = metrics_.erase(p);
+    }
+    else
+      ++p;
+  }
+}
+
+size_t
+CQToolStripMetricCache::
+memoryBytes() const
+{
+  using namespace CQToolStripMemory;
+
+  size_t bytes = 0;
+
+  for (const auto &p : metrics_)
+    bytes += mapNodeBytes + sizeof(p) + stringBytes(p.first);
+
+  return bytes;
+}
+
+CQToolStripMetricCache::Metrics
+CQToolStripMetricCache::
+widgetMetrics(QWidget *w)
+{
+  if (! enabled_)
+    return measure(w, false);
+
+  return cachedMetrics(w, widgetKey(w));
+}
+
+QSize
+CQToolStripMetricCache::
+labelSize(QLabel *label)
+{
+  if (! enabled_)
+    return label->minimumSizeHint();
+
+  return cachedMetrics(label, labelKey(label)).minSize;
+}
+
+CQToolStripMetricCache::Metrics
+CQToolStripMetricCache::
+cachedMetrics(QWidget *w, const QString &key)
+{
+  if (key.isEmpty())
+    return measure(w, false);
+
+  Metrics metrics;
+
+  if (lookup(key, metrics)) {
+    ++numHits_;
+
+    // metrics from file used until checked
+    if (! unverified_.empty() && unverified_.find(key) != unverified_.end())
+      addVerify(w, key);
+
+    return metrics;
+  }
+
+  if (lookupFile(key, metrics)) {
+    ++numFileHits_;
+
+    insert(key, metrics);
+
+    unverified_.insert(key);
+
+    addVerify(w, key);
+
+    return metrics;
+  }
+
+  ++numMisses_;
+
+  metrics = measure(w, key.startsWith(labelPrefix));
+
+  insert(key, metrics);
+
+  return metrics;
+}
+
+void
+CQToolStripMetricCache::
+clear()
+{
+  metrics_.clear();
+
+  unverified_   .clear();
+  verifyWidgets_.clear();
+  verifyQueued_ .clear();
+
+  numHits_     = 0;
+  numMisses_   = 0;
+  numFileHits_ = 0;
+}
+
+// labels use minimum size hint (as area)
+CQToolStripMetricCache::Metrics
+CQToolStripMetricCache::
+measure(QWidget *w, bool label)
+{
+  Metrics metrics;
+
+  if (label) {
+    metrics.minSize  = w->minimumSizeHint();
+    metrics.sizeHint = metrics.minSize;
+  }
+  else {
+    metrics.minSize  = CQWidgetUtil::SmartMinSize(w);
+    metrics.sizeHint = w->sizeHint();
+  }
+
+  return metrics;
+}
+
+//---
+
+// FNV-1a hash of key characters
+quint64
+CQToolStripMetricCache::
+keyHash(const QString &key)
+{
+  quint64 h = 14695981039346656037ULL;
+
+  const ushort *c = key.utf16();
+
+  for (int i = 0; i < key.length(); ++i) {
+    h ^= c[i];
+    h *= 1099511628211ULL;
+  }
+
+  return h;
+}
+
+// hash of application font, style, screen DPI and cache version (file only
+// valid for same environment)
+quint64
+CQToolStripMetricCache::
+environmentHash()
+{
+  QString env = QApplication::font().key() + "|" +
+                QApplication::style()->metaObject()->className();
+
+  QScreen *screen = QGuiApplication::primaryScreen();
+
+  if (screen)
+    env += QString("|%1|%2").arg(screen->logicalDotsPerInch()).arg(screen->devicePixelRatio());
+
+  env += QString("|%1|%2").arg(QT_VERSION_STR).arg(metricVersion);
+
+  return keyHash(env);
+}
+
+bool
+CQToolStripMetricCache::
+load(const QString &filename)
+{
+  unload();
+
+  QFile *file = new QFile(filename);
+
+  if (! file->open(QIODevice::ReadOnly)) {
+    delete file;
+    return false;
+  }
+
+  qint64 size = file->size();
+
+  uchar *data = (size >= qint64(sizeof(FileHeader)) ? file->map(0, size) : 0);
+
+  if (! data) {
+    delete file;
+    return false;
+  }
+
+  const FileHeader *header = reinterpret_cast<const FileHeader *>(data);
+
+  qint64 fileSize = qint64(sizeof(FileHeader)) + qint64(header->numEntries)*qint64(sizeof(FileEntry));
+
+  if (header->magic != fileMagic || header->version != fileVersion ||
+      header->envHash != environmentHash() || size != fileSize) {
+    delete file; // closing file unmaps data
+    return false;
+  }
+
+  // entries are used in place
+  file_           = file;
+  fileEntries_    = reinterpret_cast<const FileEntry *>(data + sizeof(FileHeader));
+  numFileEntries_ = int(header->numEntries);
+
+  return true;
+}
+
+bool
+CQToolStripMetricCache::
+save(const QString &filename)
+{
+  // file entries replaced by memory entries
+  std::map<quint64, FileEntry> entries;
+
+  for (int i = 0; i < numFileEntries_; ++i)
+    entries[fileEntries_[i].key] = fileEntries_[i];
+
+  for (const auto &p : metrics_) {
+    FileEntry entry;
+
+    entry.key        = keyHash(p.first);
+    entry.minWidth   = p.second.metrics.minSize .width ();
+    entry.minHeight  = p.second.metrics.minSize .height();
+    entry.hintWidth  = p.second.metrics.sizeHint.width ();
+    entry.hintHeight = p.second.metrics.sizeHint.height();
+
+    entries[entry.key] = entry;
+  }
+
+  // mapped file can't be replaced on all platforms
+  bool reload = (file_ && file_->fileName() == filename);
+
+  if (reload)
+    unload();
+
+  QSaveFile file(filename);
+
+  if (! file.open(QIODevice::WriteOnly))
+    return false;
+
+  FileHeader header;
+
+  header.magic      = fileMagic;
+  header.version    = fileVersion;
+  header.envHash    = environmentHash();
+  header.numEntries = quint32(entries.size());
+  header.reserved   = 0;
+
+  file.write(reinterpret_cast<const char *>(&header), sizeof(header));
+
+  // map is sorted by key
+  for (const auto &p : entries)
+    file.write(reinterpret_cast<const char *>(&p.second), sizeof(FileEntry));
+
+  bool rc = file.commit();
+
+  if (reload)
+    load(filename);
+
+  return rc;
+}
+
+void
+CQToolStripMetricCache::
+unload()
+{
+  delete file_;
+
+  file_           = 0;
+  fileEntries_    = 0;
+  numFileEntries_ = 0;
+}
+
+bool
+CQToolStripMetricCache::
+lookupFile(const QString &key, Metrics &metrics) const
+{
+  if (! numFileEntries_)
+    return false;
+
+  quint64 h = keyHash(key);
+
+  const FileEntry *end = fileEntries_ + numFileEntries_;
+
+  const FileEntry *p = std::lower_bound(fileEntries_, end, h,
+    [](const FileEntry &entry, quint64 key) { return entry.key < key; });
+
+  if (p == end || p->key != h)
+    return false;
+
+  metrics.minSize  = QSize(p->minWidth , p->minHeight );
+  metrics.sizeHint = QSize(p->hintWidth, p->hintHeight);
+
+  return true;
+}
+
+// check metrics from file after first layout (and paint)
+void
+CQToolStripMetricCache::
+addVerify(QWidget *w, const QString &key)
+{
+  if (! verifyQueued_.insert(w).second)
+    return;
+
+  verifyWidgets_.push_back(VerifyWidget(w, key));
+
+  if (! verifyTimer_) {
+    verifyTimer_ = new QTimer(this);
+
+    verifyTimer_->setSingleShot(true);
+    verifyTimer_->setInterval(100);
+
+    connect(verifyTimer_, SIGNAL(timeout()), this, SLOT(verifySlot()));
+  }
+
+  if (! verifyTimer_->isActive())
+    verifyTimer_->start();
+}
+
+// measure widgets sized from file and update widgets if size changed
+void
+CQToolStripMetricCache::
+verifySlot()
+{
+  VerifyWidgets widgets;
+
+  std::swap(widgets, verifyWidgets_);
+
+  verifyQueued_.clear();
+
+  std::set<QString> changed;
+
+  for (const auto &vw : widgets) {
+    QWidget       *w   = vw.first;
+    const QString &key = vw.second;
+
+    if (! w) continue;
+
+    // widget contents changed since queued
+    bool label = key.startsWith(labelPrefix);
+
+    QString key1 = (label ? labelKey(static_cast<QLabel *>(w)) : widgetKey(w));
+
+    if (key1 != key) continue;
+
+    if (unverified_.find(key) != unverified_.end()) {
+      Metrics metrics = measure(w, label);
+
+      Metrics &metrics1 = metrics_[key].metrics;
+
+      if (metrics.minSize != metrics1.minSize || metrics.sizeHint != metrics1.sizeHint) {
+        metrics1 = metrics;
+
+        changed.insert(key);
+      }
+
+      unverified_.erase(key);
+    }
+
+    // size hint change relayouts area
+    if (changed.find(key) != changed.end())
+      w->updateGeometry();
+  }
+}
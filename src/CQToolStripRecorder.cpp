@@ -0,0 +1,405 @@
+#include <CQToolStripRecorder.h>
+#include <CQToolStrip.h>
+#include <CQToolStripMetricCache.h>
+#include <CQToolStripSpec.h>
+#include <QFile>
+#include <QDataStream>
+#include <QEvent>
+
+// recording file header
+static const quint32 recordMagic   = 0x43515452; // 'CQTR'
+static const quint8  recordVersion = 2; // 2 adds strip config, groups and area flags
+
+namespace {
+
+// number of values stored for event type
+int numEventValues(CQToolStripRecording::EventType type) {
+  switch (type) {
+    case CQToolStripRecording::ResizeEvent  : return 2;
+    case CQToolStripRecording::SplitterEvent: return 2;
+    case CQToolStripRecording::MenuRectEvent: return 4;
+    default                                 : return 0;
+  }
+}
+
+}
+
+bool
+CQToolStripRecording::
+save(const QString &filename) const
+{
+  QFile file(filename);
+
+  if (! file.open(QIODevice::WriteOnly))
+    return false;
+
+  QDataStream ds(&file);
+
+  ds.setVersion(QDataStream::Qt_5_0);
+
+  ds << recordMagic << recordVersion;
+
+  ds << qint32(orientation) << qint32(windowSize.width()) << qint32(windowSize.height());
+
+  ds << qint32(overflowPolicy) << quint8(popupHost);
+
+  ds << quint32(areas.size());
+
+  for (const auto &area : areas) {
+    ds << area.label << area.className << quint8(area.resizable) << qint32(area.displayWidth);
+
+    ds << qint32(area.minSize .width()) << qint32(area.minSize .height());
+    ds << qint32(area.sizeHint.width()) << qint32(area.sizeHint.height());
+
+    ds << quint8(area.hidden) << quint8(area.nested);
+  }
+
+  ds << quint32(groups.size());
+
+  for (const auto &group : groups)
+    ds << group.name << qint32(group.start) << qint32(group.end) << quint8(group.collapsed);
+
+  ds << quint32(events.size());
+
+  for (const auto &event : events) {
+    ds << quint8(event.type) << event.time;
+
+    int nv = numEventValues(event.type);
+
+    for (int i = 0; i < nv; ++i)
+      ds << event.values[i];
+  }
+
+  return (ds.status() == QDataStream::Ok);
+}
+
+bool
+CQToolStripRecording::
+load(const QString &filename)
+{
+  QFile file(filename);
+
+  if (! file.open(QIODevice::ReadOnly))
+    return false;
+
+  QDataStream ds(&file);
+
+  ds.setVersion(QDataStream::Qt_5_0);
+
+  quint32 magic;
+  quint8  version;
+
+  ds >> magic >> version;
+
+  if (ds.status() != QDataStream::Ok || magic != recordMagic ||
+      version < 1 || version > recordVersion)
+    return false;
+
+  qint32 orient, w, h;
+
+  ds >> orient >> w >> h;
+
+  orientation = Qt::Orientation(orient);
+  windowSize  = QSize(w, h);
+
+  overflowPolicy = 0;
+  popupHost      = false;
+
+  if (version >= 2) {
+    qint32 policy;
+    quint8 host;
+
+    ds >> policy >> host;
+
+    overflowPolicy = policy;
+    popupHost      = host;
+  }
+
+  quint32 na;
+
+  ds >> na;
+
+  areas.clear();
+
+  for (quint32 i = 0; i < na && ds.status() == QDataStream::Ok; ++i) {
+    Area area;
+
+    quint8 resizable;
+    qint32 displayWidth, mw, mh, sw, sh;
+
+    ds >> area.label >> area.className >> resizable >> displayWidth >> mw >> mh >> sw >> sh;
+
+    area.resizable    = resizable;
+    area.displayWidth = displayWidth;
+    area.minSize      = QSize(mw, mh);
+    area.sizeHint     = QSize(sw, sh);
+
+    if (version >= 2) {
+      quint8 hidden, nested;
+
+      ds >> hidden >> nested;
+
+      area.hidden = hidden;
+      area.nested = nested;
+    }
+
+    areas.push_back(area);
+  }
+
+  groups.clear();
+
+  if (version >= 2) {
+    quint32 ng;
+
+    ds >> ng;
+
+    for (quint32 i = 0; i < ng && ds.status() == QDataStream::Ok; ++i) {
+      Group group;
+
+      qint32 start, end;
+      quint8 collapsed;
+
+      ds >> group.name >> start >> end >> collapsed;
+
+      group.start     = start;
+      group.end       = end;
+      group.collapsed = collapsed;
+
+      groups.push_back(group);
+    }
+  }
+
+  quint32 ne;
+
+  ds >> ne;
+
+  events.clear();
+
+  for (quint32 i = 0; i < ne && ds.status() == QDataStream::Ok; ++i) {
+    quint8 type;
+
+    Event event;
+
+    ds >> type >> event.time;
+
+    event.type = EventType(type);
+
+    int nv = numEventValues(event.type);
+
+    for (int j = 0; j < nv; ++j)
+      ds >> event.values[j];
+
+    events.push_back(event);
+  }
+
+  return (ds.status() == QDataStream::Ok);
+}
+
+const char *
+CQToolStripRecording::
+eventName(EventType type)
+{
+  switch (type) {
+    case ResizeEvent   : return "resize";
+    case SplitterEvent : return "splitter";
+    case MenuOpenEvent : return "menu_open";
+    case MenuCloseEvent: return "menu_close";
+    case MenuRectEvent : return "menu_rect";
+    default            : return "unknown";
+  }
+}
+
+//------
+
+CQToolStripRecorder::
+CQToolStripRecorder(CQToolStrip *strip) :
+ QObject(strip), strip_(strip), window_(0), recording_(false)
+{
+}
+
+void
+CQToolStripRecorder::
+start()
+{
+  if (recording_)
+    stop();
+
+  data_ = CQToolStripRecording();
+
+  // strip state
+  window_ = strip_->window();
+
+  data_.orientation    = strip_->orientation();
+  data_.overflowPolicy = int(strip_->overflowPolicy());
+  data_.popupHost      = strip_->isPopupHost();
+  data_.windowSize     = window_->size();
+
+  int n = strip_->numAreas();
+
+  for (int i = 0; i < n; ++i) {
+    auto *area = strip_->getArea(i);
+    auto *w    = area->widget();
+
+    CQToolStripRecording::Area rarea;
+
+    rarea.label        = area->labelText();
+    rarea.className    = (w ? w->metaObject()->className() : "");
+    rarea.resizable    = area->isResizable();
+    rarea.hidden       = area->isHiddenByUser();
+    rarea.nested       = (area->nestedStrip() != 0);
+    rarea.displayWidth = (area->hasDisplayWidth() ? area->displayWidth() : -1);
+
+    // same metrics as area size hints (smart minimum size of widget)
+    if (w) {
+      auto metrics = CQToolStripMetricCache::instance()->widgetMetrics(w);
+
+      rarea.minSize  = metrics.minSize;
+      rarea.sizeHint = metrics.sizeHint;
+    }
+    else if (area->widgetFactory()) {
+      auto *factory = area->widgetFactory();
+
+      rarea.minSize  = factory->minimumSizeHint(area->widgetFactoryId());
+      rarea.sizeHint = factory->sizeHint       (area->widgetFactoryId());
+    }
+
+    data_.areas.push_back(rarea);
+  }
+
+  int ng = strip_->numGroups();
+
+  for (int i = 0; i < ng; ++i) {
+    auto *group = strip_->getGroup(i);
+
+    CQToolStripRecording::Group rgroup;
+
+    rgroup.name      = group->name();
+    rgroup.collapsed = group->isCollapsed();
+
+    for (int j = 0; j < n; ++j) {
+      if (strip_->getArea(j)->group() != group) continue;
+
+      if (rgroup.start < 0)
+        rgroup.start = j;
+
+      rgroup.end = j;
+    }
+
+    if (rgroup.start >= 0)
+      data_.groups.push_back(rgroup);
+  }
+
+  //---
+
+  window_->installEventFilter(this);
+
+  connect(strip_, SIGNAL(splitterDragged(int, int)), this, SLOT(splitterSlot(int, int)));
+
+  connect(strip_->menu_, SIGNAL(openMenu()), this, SLOT(menuOpenSlot()));
+  connect(strip_->menu_, SIGNAL(closeMenu()), this, SLOT(menuCloseSlot()));
+
+  connect(strip_->menu_, SIGNAL(menuRectAdjusted(int, int, int, int)),
+          this, SLOT(menuRectSlot(int, int, int, int)));
+
+  recording_ = true;
+
+  timer_.start();
+}
+
+void
+CQToolStripRecorder::
+stop()
+{
+  if (! recording_)
+    return;
+
+  window_->removeEventFilter(this);
+
+  disconnect(strip_, SIGNAL(splitterDragged(int, int)), this, SLOT(splitterSlot(int, int)));
+
+  disconnect(strip_->menu_, SIGNAL(openMenu()), this, SLOT(menuOpenSlot()));
+  disconnect(strip_->menu_, SIGNAL(closeMenu()), this, SLOT(menuCloseSlot()));
+
+  disconnect(strip_->menu_, SIGNAL(menuRectAdjusted(int, int, int, int)),
+             this, SLOT(menuRectSlot(int, int, int, int)));
+
+  recording_ = false;
+}
+
+bool
+CQToolStripRecorder::
+eventFilter(QObject *o, QEvent *e)
+{
+  if (o == window_ && e->type() == QEvent::Resize)
+    addEvent(CQToolStripRecording::ResizeEvent, window_->width(), window_->height());
+
+  return false;
+}
+
+void
+CQToolStripRecorder::
+splitterSlot(int ind, int d)
+{
+  addEvent(CQToolStripRecording::SplitterEvent, ind, d);
+}
+
+void
+CQToolStripRecorder::
+menuOpenSlot()
+{
+  addEvent(CQToolStripRecording::MenuOpenEvent);
+}
+
+void
+CQToolStripRecorder::
+menuCloseSlot()
+{
+  addEvent(CQToolStripRecording::MenuCloseEvent);
+}
+
+void
+CQToolStripRecorder::
+menuRectSlot(int dxl, int dyb, int dxr, int dyt)
+{
+  addEvent(CQToolStripRecording::MenuRectEvent, dxl, dyb, dxr, dyt);
+}
+
+void
+CQToolStripRecorder::
+addEvent(CQToolStripRecording::EventType type, int v1, int v2, int v3, int v4)
+{
+  auto time = quint32(timer_.elapsed());
+
+  data_.events.push_back(CQToolStripRecording::Event(type, time, v1, v2, v3, v4));
+}
+
+void
+CQToolStripRecorder::
+applyEvent(CQToolStrip *strip, const CQToolStripRecording::Event &event)
+{
+  const auto &v = event.values;
+
+  switch (event.type) {
+    case CQToolStripRecording::ResizeEvent:
+      strip->window()->resize(v[0], v[1]);
+      break;
+    case CQToolStripRecording::SplitterEvent:
+      if (v[0] >= 0 && v[0] < strip->numAreas())
+        strip->splitterMoved(v[0], v[1]);
+      break;
+    case CQToolStripRecording::MenuOpenEvent:
+      if (! strip->menu_->isOpen())
+        strip->popupMenu();
+      break;
+    case CQToolStripRecording::MenuCloseEvent:
+      if (strip->menu_->isOpen())
+        strip->menu_->hidePopup();
+      break;
+    case CQToolStripRecording::MenuRectEvent:
+      if (strip->menu_->isOpen())
+        strip->menu_->adjustMenuRect(v[0], v[1], v[2], v[3]);
+      break;
+    default:
+      break;
+  }
+}
@@ -0,0 +1,104 @@
+#include <CQToolStripSearchIndex.h>
+#include <CQToolStripMemory.h>
+#include <algorithm>
+
+void
+CQToolStripSearchIndex::
+build(const std::vector<QString> &strs)
+{
+  clear();
+
+  int n = int(strs.size());
+
+  strs_.resize(uint(n));
+
+  for (int i = 0; i < n; ++i) {
+    const QString &str = (strs_[uint(i)] = strs[uint(i)].toLower());
+
+    for (int j = 0; j + 3 <= str.length(); ++j) {
+      Inds &inds = trigrams_[str.mid(j, 3)];
+
+      // same trigram may occur more than once in string
+      if (inds.empty() || inds.back() != i)
+        inds.push_back(i);
+    }
+  }
+}
+
+void
+CQToolStripSearchIndex::
+clear()
+{
+  strs_    .clear();
+  trigrams_.clear();
+}
+
+size_t
+CQToolStripSearchIndex::
+memoryBytes() const
+{
+  using namespace CQToolStripMemory;
+
+  size_t bytes = vectorBytes(strs_);
+
+  for (const auto &str : strs_)
+    bytes += stringBytes(str);
+
+  for (const auto &p : trigrams_)
+    bytes += mapNodeBytes + sizeof(p) + stringBytes(p.first) + vectorBytes(p.second);
+
+  return bytes;
+}
+
+CQToolStripSearchIndex::Inds
+CQToolStripSearchIndex::
+match(const QString &text) const
+{
+  QString text1 = text.toLower();
+
+  int n = size();
+
+  Inds inds;
+
+  if (text1.length() < 3) {
+    for (int i = 0; i < n; ++i) {
+      if (strs_[uint(i)].contains(text1))
+        inds.push_back(i);
+    }
+
+    return inds;
+  }
+
+  //---
+
+  // get shortest trigram list
+  const Inds *minInds = 0;
+
+  for (int j = 0; j + 3 <= text1.length(); ++j) {
+    auto p = trigrams_.find(text1.mid(j, 3));
+
+    if (p == trigrams_.end())
+      return inds;
+
+    if (! minInds || (*p).second.size() < minInds->size())
+      minInds = &(*p).second;
+  }
+
+  return match(text1, *minInds);
+}
+
+CQToolStripSearchIndex::Inds
+CQToolStripSearchIndex::
+match(const QString &text, const Inds &candidates) const
+{
+  QString text1 = text.toLower();
+
+  Inds inds;
+
+  for (int i : candidates) {
+    if (strs_[uint(i)].contains(text1))
+      inds.push_back(i);
+  }
+
+  return inds;
+}
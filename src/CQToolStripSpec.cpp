@@ -0,0 +1,176 @@
+#include <CQToolStripSpec.h>
+#include <CQToolStrip.h>
+#include <QFile>
+#include <QJsonDocument>
+#include <QJsonObject>
+#include <QJsonArray>
+#include <map>
+
+namespace {
+
+typedef std::map<QString, CQToolStripWidgetFactory *> Factories;
+
+Factories &factories() {
+  static Factories factories;
+
+  return factories;
+}
+
+}
+
+CQToolStripSpec::
+CQToolStripSpec() :
+ orientation_(Qt::Horizontal)
+{
+}
+
+void
+CQToolStripSpec::
+registerFactory(const QString &key, CQToolStripWidgetFactory *factory)
+{
+  factories()[key] = factory;
+}
+
+void
+CQToolStripSpec::
+unregisterFactory(const QString &key)
+{
+  factories().erase(key);
+}
+
+CQToolStripWidgetFactory *
+CQToolStripSpec::
+factory(const QString &key)
+{
+  auto p = factories().find(key);
+
+  return (p != factories().end() ? (*p).second : 0);
+}
+
+bool
+CQToolStripSpec::
+load(const QString &filename)
+{
+  QFile file(filename);
+
+  if (! file.open(QIODevice::ReadOnly)) {
+    errorString_ = QString("Failed to open '%1'").arg(filename);
+    return false;
+  }
+
+  return parse(file.readAll());
+}
+
+bool
+CQToolStripSpec::
+parse(const QByteArray &json)
+{
+  errorString_ = "";
+
+  QJsonParseError error;
+
+  QJsonDocument doc = QJsonDocument::fromJson(json, &error);
+
+  if (doc.isNull()) {
+    errorString_ = error.errorString();
+    return false;
+  }
+
+  if (! doc.isObject()) {
+    errorString_ = "Spec is not an object";
+    return false;
+  }
+
+  QJsonObject obj = doc.object();
+
+  //---
+
+  QString orient = obj.value("orientation").toString("horizontal");
+
+  if      (orient == "horizontal")
+    orientation_ = Qt::Horizontal;
+  else if (orient == "vertical")
+    orientation_ = Qt::Vertical;
+  else {
+    errorString_ = QString("Invalid orientation '%1'").arg(orient);
+    return false;
+  }
+
+  //---
+
+  QJsonValue areas = obj.value("areas");
+
+  if (! areas.isArray()) {
+    errorString_ = "Missing areas array";
+    return false;
+  }
+
+  Items items;
+
+  QJsonArray areaArray = areas.toArray();
+
+  for (int i = 0; i < areaArray.size(); ++i) {
+    QJsonValue value = areaArray.at(i);
+
+    if (! value.isObject()) {
+      errorString_ = QString("Area %1 is not an object").arg(i);
+      return false;
+    }
+
+    QJsonObject areaObj = value.toObject();
+
+    Item item;
+
+    item.id        = areaObj.value("id"       ).toString();
+    item.label     = areaObj.value("label"    ).toString();
+    item.factory   = areaObj.value("factory"  ).toString();
+    item.resizable = areaObj.value("resizable").toBool(false);
+    item.priority  = areaObj.value("priority" ).toInt(0);
+    item.width     = areaObj.value("width"    ).toInt(-1);
+
+    if (item.factory == "") {
+      errorString_ = QString("Area %1 has no factory").arg(i);
+      return false;
+    }
+
+    items.push_back(item);
+  }
+
+  items_ = items;
+
+  return true;
+}
+
+CQToolStripSpec::Areas
+CQToolStripSpec::
+apply(CQToolStrip *strip) const
+{
+  strip->setOrientation(orientation_);
+
+  Areas areas;
+
+  for (const auto &item : items_) {
+    CQToolStripArea *area = new CQToolStripArea(strip);
+
+    area->setObjectName(item.id);
+
+    auto *factory = CQToolStripSpec::factory(item.factory);
+
+    if (factory)
+      area->setWidgetFactory(factory, item.id);
+
+    if (item.label != "")
+      area->setLabel(item.label);
+
+    area->setResizable(item.resizable);
+
+    if (item.width >= 0)
+      area->setDisplayWidth(item.width);
+
+    areas.push_back(area);
+  }
+
+  strip->addAreas(areas);
+
+  return areas;
+}
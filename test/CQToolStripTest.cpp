@@ -1,11 +1,20 @@
 #include <CQToolStripTest.h>
 #include <CQToolStrip.h>
+#include <CQToolStripRecorder.h>
+#include <CQToolStripSpec.h>
+#include <CQToolStripMetricCache.h>
 #include <QApplication>
 #include <QVBoxLayout>
 #include <QPushButton>
 #include <QLineEdit>
 #include <QToolButton>
+#include <QComboBox>
+#include <QCheckBox>
+#include <QLabel>
+#include <QTimer>
 #include <iostream>
+#include <random>
+#include <cmath>
 
 class LineEdit : public QLineEdit {
  public:
@@ -27,31 +36,170 @@ class LineEdit : public QLineEdit {
   }
 };
 
+// create widget of type (button, edit, combo, label, check) with text id
+static QWidget *
+createWidget(const QString &type, const QString &id)
+{
+  if      (type == "edit")
+    return new LineEdit;
+  else if (type == "combo") {
+    QComboBox *combo = new QComboBox;
+
+    combo->addItems(QStringList() << "One" << "Two" << "Three");
+
+    return combo;
+  }
+  else if (type == "label")
+    return new QLabel(QString("Label %1").arg(id));
+  else if (type == "check")
+    return new QCheckBox(QString("Check %1").arg(id));
+  else
+    return new QPushButton(QString("Button %1").arg(id));
+}
+
+// spec widget factory for type (size from prototype widget)
+class TestWidgetFactory : public CQToolStripWidgetFactory {
+ public:
+  TestWidgetFactory(const QString &type) :
+   type_(type) {
+  }
+
+  QWidget *createWidget(const QString &id) override {
+    return ::createWidget(type_, id);
+  }
+
+  QSize sizeHint(const QString &) const override {
+    measure(); return sizeHint_;
+  }
+
+  QSize minimumSizeHint(const QString &) const override {
+    measure(); return minSize_;
+  }
+
+ private:
+  void measure() const {
+    if (sizeHint_.isValid()) return;
+
+    QWidget *w = ::createWidget(type_, "");
+
+    sizeHint_ = w->sizeHint();
+    minSize_  = w->minimumSizeHint();
+
+    delete w;
+  }
+
+ private:
+  QString       type_;
+  mutable QSize sizeHint_;
+  mutable QSize minSize_;
+};
+
 int
 main(int argc, char **argv)
 {
   QApplication app(argc, argv);
 
-  CQToolStripTest *test = new CQToolStripTest;
+  // record interaction for CQToolStripReplay
+  QString recordFile;
+
+  // persistent metric cache (loaded at start and saved at exit)
+  QString metricFile;
+
+  CQToolStripTest::Options options;
+
+  for (int i = 1; i < argc; ++i) {
+    QString arg = argv[i];
+
+    bool hasValue = (i < argc - 1);
+
+    if      (arg == "-record" && hasValue)
+      recordFile = argv[++i];
+    // stress mode
+    else if (arg == "-stress")
+      options.stress = true;
+    else if (arg == "-areas" && hasValue) {
+      options.stress = true; options.numAreas = QString(argv[++i]).toInt(); }
+    else if (arg == "-mix" && hasValue) {
+      options.stress = true; options.mix = QString(argv[++i]).split(",", Qt::SkipEmptyParts); }
+    else if (arg == "-labels" && hasValue) {
+      options.stress = true; options.labelRatio = QString(argv[++i]).toDouble(); }
+    else if (arg == "-resizable" && hasValue) {
+      options.stress = true; options.resizableRatio = QString(argv[++i]).toDouble(); }
+    else if (arg == "-nested" && hasValue) {
+      options.stress = true; options.numNested = QString(argv[++i]).toInt(); }
+    else if (arg == "-sweep" && hasValue) {
+      options.stress = true; options.sweep = argv[++i]; }
+    else if (arg == "-seed" && hasValue)
+      options.seed = QString(argv[++i]).toInt();
+    else if (arg == "-spec" && hasValue)
+      options.spec = argv[++i];
+    else if (arg == "-metric_cache" && hasValue)
+      metricFile = argv[++i];
+    else {
+      std::cerr << "Usage: CQToolStripTest [-record <file>] [-stress] [-areas <n>] "
+                   "[-mix button,edit,combo,label,check] [-labels <ratio>] "
+                   "[-resizable <ratio>] [-nested <n>] [-sweep resize|splitter|both] "
+                   "[-seed <n>] [-spec <file>] [-metric_cache <file>]" << std::endl;
+      return 1;
+    }
+  }
+
+  auto *metricCache = CQToolStripMetricCache::instance();
+
+  if (metricFile != "") {
+    metricCache->setEnabled(true);
+
+    metricCache->load(metricFile);
+  }
+
+  CQToolStripTest *test = new CQToolStripTest(options);
 
   test->show();
 
-  return app.exec();
+  CQToolStripRecorder *recorder = 0;
+
+  if (recordFile != "") {
+    recorder = new CQToolStripRecorder(test->strip());
+
+    recorder->start();
+  }
+
+  int rc = app.exec();
+
+  if (options.stress)
+    test->strip()->dumpMemory(std::cerr);
+
+  if (metricFile != "" && ! metricCache->save(metricFile))
+    std::cerr << "Failed to save '" << metricFile.toStdString() << "'" << std::endl;
+
+  if (recorder && ! recorder->save(recordFile))
+    std::cerr << "Failed to save '" << recordFile.toStdString() << "'" << std::endl;
+
+  return rc;
 }
 
 CQToolStripTest::
-CQToolStripTest()
+CQToolStripTest(const Options &options) :
+ options_(options), overlay_(0), sweepTimer_(0), overlayTimer_(0), frameTime_(0.0),
+ maxFrameTime_(0.0), layoutTime_(0.0), maxLayoutTime_(0.0), numPasses_(0), numFrames_(0),
+ sweepStep_(0)
 {
   QVBoxLayout *layout = new QVBoxLayout(this);
-  layout->setMargin(2); layout->setSpacing(2);
+  layout->setContentsMargins(2, 2, 2, 2); layout->setSpacing(2);
 
   strip_ = new CQToolStrip;
 
-  strip_->addWidget("Button", new QPushButton("One"));
-  strip_->addWidget("Edit 1", new LineEdit());
-  strip_->addWidget("Tool"  , new QToolButton());
-  strip_->addWidget("Edit 2", new LineEdit());
-  strip_->addWidget(new QToolButton());
+  if      (options_.spec != "")
+    addSpecAreas();
+  else if (! options_.stress) {
+    strip_->addWidget("Button", new QPushButton("One"));
+    strip_->addWidget("Edit 1", new LineEdit());
+    strip_->addWidget("Tool"  , new QToolButton());
+    strip_->addWidget("Edit 2", new LineEdit());
+    strip_->addWidget(new QToolButton());
+  }
+  else
+    addStressAreas();
 
   layout->addWidget(strip_);
 
@@ -60,4 +208,247 @@ CQToolStripTest()
   connect(button, SIGNAL(clicked()), this, SLOT(close()));
 
   layout->addWidget(button);
+
+  if (! options_.stress)
+    return;
+
+  //---
+
+  // overlay (not in layout) showing frame time, layout time and widget operations
+  overlay_ = new QLabel(this);
+
+  overlay_->setAttribute(Qt::WA_TransparentForMouseEvents);
+  overlay_->setStyleSheet("background: rgba(0, 0, 0, 160); color: white; padding: 4px;");
+
+  connect(strip_, SIGNAL(layoutSettled()), this, SLOT(layoutSettledSlot()));
+
+  // count widget operations for whole application
+  qApp->installEventFilter(this);
+
+  overlayTimer_ = new QTimer(this);
+
+  overlayTimer_->setInterval(16);
+
+  connect(overlayTimer_, SIGNAL(timeout()), this, SLOT(overlaySlot()));
+
+  overlayTimer_->start();
+
+  frameTimer_.start();
+
+  if (options_.sweep != "") {
+    sweepTimer_ = new QTimer(this);
+
+    sweepTimer_->setInterval(16);
+
+    connect(sweepTimer_, SIGNAL(timeout()), this, SLOT(sweepSlot()));
+
+    sweepTimer_->start();
+  }
+
+  resize(1000, sizeHint().height());
+}
+
+// add generated areas for stress options (same seed gives same strip)
+void
+CQToolStripTest::
+addStressAreas()
+{
+  std::mt19937 rand(uint(options_.seed));
+
+  std::uniform_real_distribution<double> ratio(0.0, 1.0);
+
+  QStringList mix = options_.mix;
+
+  if (mix.empty())
+    mix << "button";
+
+  int numAreas  = std::max(options_.numAreas, 0);
+  int numNested = std::max(options_.numNested, 0);
+
+  // nested strips spread evenly through areas
+  int nestedStep = (numNested > 0 ? std::max(numAreas/numNested, 1) : 0);
+  int numAdded   = 0;
+
+  for (int i = 0; i < numAreas; ++i) {
+    const QString &type = mix[int(rand() % uint(mix.size()))];
+
+    QWidget *w = createWidget(type, QString::number(i));
+
+    CQToolStripArea *area;
+
+    if (ratio(rand) < options_.labelRatio)
+      area = strip_->addWidget(QString("Area %1").arg(i), w);
+    else
+      area = strip_->addWidget(w);
+
+    area->setResizable(ratio(rand) < options_.resizableRatio);
+
+    if (nestedStep > 0 && numAdded < numNested && (i + 1) % nestedStep == 0) {
+      CQToolStrip *nested = new CQToolStrip;
+
+      for (int j = 0; j < 8; ++j)
+        nested->addWidget(createWidget(mix[j % mix.size()], QString::number(j)));
+
+      strip_->addWidget(QString("Nested %1").arg(numAdded), nested);
+
+      ++numAdded;
+    }
+  }
+}
+
+// add areas from spec file (widgets created when first shown)
+void
+CQToolStripTest::
+addSpecAreas()
+{
+  static TestWidgetFactory buttonFactory("button"), editFactory("edit"),
+    comboFactory("combo"), labelFactory("label"), checkFactory("check");
+
+  CQToolStripSpec::registerFactory("button", &buttonFactory);
+  CQToolStripSpec::registerFactory("edit"  , &editFactory  );
+  CQToolStripSpec::registerFactory("combo" , &comboFactory );
+  CQToolStripSpec::registerFactory("label" , &labelFactory );
+  CQToolStripSpec::registerFactory("check" , &checkFactory );
+
+  CQToolStripSpec spec;
+
+  if (! spec.load(options_.spec)) {
+    std::cerr << "Invalid spec '" << options_.spec.toStdString() << "': " <<
+                 spec.errorString().toStdString() << std::endl;
+    return;
+  }
+
+  spec.apply(strip_);
+}
+
+bool
+CQToolStripTest::
+eventFilter(QObject *o, QEvent *e)
+{
+  if (! o->isWidgetType() || o == overlay_)
+    return false;
+
+  switch (e->type()) {
+    case QEvent::Move  : ++counts_.moves  ; break;
+    case QEvent::Resize: ++counts_.resizes; break;
+    case QEvent::Show  : ++counts_.shows  ; break;
+    case QEvent::Hide  : ++counts_.hides  ; break;
+    default            :                    break;
+  }
+
+  // layout pass time is from strip resize to layout settled
+  if (o == strip_ && e->type() == QEvent::Resize)
+    passTimer_.start();
+
+  return false;
+}
+
+void
+CQToolStripTest::
+layoutSettledSlot()
+{
+  if (! passTimer_.isValid())
+    return;
+
+  addLayoutTime(passTimer_.nsecsElapsed()/1e6);
+
+  passTimer_.invalidate();
+}
+
+void
+CQToolStripTest::
+addLayoutTime(double ms)
+{
+  layoutTime_    = ms;
+  maxLayoutTime_ = std::max(maxLayoutTime_, ms);
+
+  ++numPasses_;
+}
+
+// sweep window width (resize) and/or resizable area width (splitter)
+void
+CQToolStripTest::
+sweepSlot()
+{
+  static const int minWidth = 200, maxWidth = 1600, phaseSteps = 400;
+
+  int step = sweepStep_++;
+
+  bool resizeSweep = (options_.sweep == "resize");
+
+  if (options_.sweep == "both")
+    resizeSweep = ((step/phaseSteps) % 2 == 0);
+
+  if (resizeSweep) {
+    // triangle wave between min and max width (8 pixels per step)
+    int range = maxWidth - minWidth;
+    int w     = minWidth + std::abs((step*8) % (2*range) - range);
+
+    CQToolStripRecording::Event event(CQToolStripRecording::ResizeEvent, 0, w, height());
+
+    CQToolStripRecorder::applyEvent(strip_, event);
+  }
+  else {
+    // drag first visible resizable splitter out and back (20 steps each way)
+    int ind = -1;
+
+    for (int i = 0; i < strip_->numAreas() - 1; ++i) {
+      CQToolStripArea *area = strip_->getArea(i);
+
+      if (area->isResizable() && ! area->isClipped()) {
+        ind = i;
+        break;
+      }
+    }
+
+    if (ind < 0)
+      return;
+
+    int d = ((step/20) % 2 == 0 ? 8 : -8);
+
+    CQToolStripRecording::Event event(CQToolStripRecording::SplitterEvent, 0, ind, d);
+
+    // splitter layout is synchronous
+    QElapsedTimer timer;
+
+    timer.start();
+
+    CQToolStripRecorder::applyEvent(strip_, event);
+
+    addLayoutTime(timer.nsecsElapsed()/1e6);
+  }
+}
+
+// frame time is interval between (16ms) overlay ticks so includes any blocked event loop
+void
+CQToolStripTest::
+overlaySlot()
+{
+  frameTime_    = frameTimer_.nsecsElapsed()/1e6;
+  maxFrameTime_ = std::max(maxFrameTime_, frameTime_);
+
+  frameTimer_.restart();
+
+  // update text every 10 frames (counts are per update)
+  if (++numFrames_ < 10)
+    return;
+
+  overlay_->setText(QString("%1 areas\n"
+                            "frame %2 ms (max %3)\n"
+                            "layout %4 ms (max %5) passes %6\n"
+                            "move %7 resize %8 show %9 hide %10").
+    arg(strip_->numAreas()).
+    arg(frameTime_, 0, 'f', 1).arg(maxFrameTime_, 0, 'f', 1).
+    arg(layoutTime_, 0, 'f', 2).arg(maxLayoutTime_, 0, 'f', 2).arg(numPasses_).
+    arg(counts_.moves).arg(counts_.resizes).arg(counts_.shows).arg(counts_.hides));
+
+  overlay_->adjustSize();
+
+  overlay_->move(width() - overlay_->width() - 4, height() - overlay_->height() - 4);
+  overlay_->raise();
+  overlay_->show();
+
+  numFrames_    = 0;
+  maxFrameTime_ = 0.0;
+  counts_       = Counts();
 }
@@ -1,13 +1,84 @@
 #include <QDialog>
+#include <QElapsedTimer>
+#include <QStringList>
 
 class CQToolStrip;
+class QLabel;
+class QTimer;
 
 class CQToolStripTest : public QDialog {
   Q_OBJECT
 
  public:
-  CQToolStripTest();
+  //! stress mode options (from command line)
+  struct Options {
+    bool        stress;
+    int         numAreas;
+    QStringList mix;            // widget types (button, edit, combo, label, check)
+    double      labelRatio;     // fraction of areas with label
+    double      resizableRatio; // fraction of areas which are resizable
+    int         numNested;      // number of nested strips
+    QString     sweep;          // automated sweep (resize, splitter, both)
+    int         seed;
+    QString     spec;           // JSON strip spec file (widgets created on demand)
+
+    Options() :
+     stress(false), numAreas(1000), labelRatio(0.5), resizableRatio(0.2), numNested(0),
+     seed(1) {
+      mix << "button" << "edit" << "combo" << "label" << "check";
+    }
+  };
+
+ public:
+  CQToolStripTest(const Options &options=Options());
+
+  CQToolStrip *strip() const { return strip_; }
+
+ private:
+  void addStressAreas();
+
+  void addSpecAreas();
+
+  bool eventFilter(QObject *o, QEvent *e) override;
+
+  void addLayoutTime(double ms);
+
+ private slots:
+  void layoutSettledSlot();
+
+  void sweepSlot();
+
+  void overlaySlot();
 
  private:
-  CQToolStrip *strip_;
+  // widget operation counts (since last overlay update)
+  struct Counts {
+    int moves;
+    int resizes;
+    int shows;
+    int hides;
+
+    Counts() {
+      moves   = 0;
+      resizes = 0;
+      shows   = 0;
+      hides   = 0;
+    }
+  };
+
+  Options       options_;
+  CQToolStrip  *strip_;
+  QLabel       *overlay_;
+  QTimer       *sweepTimer_;
+  QTimer       *overlayTimer_;
+  QElapsedTimer frameTimer_;
+  QElapsedTimer passTimer_;
+  double        frameTime_;
+  double        maxFrameTime_;
+  double        layoutTime_;
+  double        maxLayoutTime_;
+  int           numPasses_;
+  int           numFrames_;
+  Counts        counts_;
+  int           sweepStep_;
 };
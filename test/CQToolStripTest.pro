@@ -4,7 +4,7 @@ TARGET = CQToolStripTest
 
 DEPENDPATH += .
 
-QT += widgets
+QT += widgets concurrent
 
 #CONFIG += debug
 